@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <json5/json5.hpp>
+
+// null terminated copy of the fuzzer input, the parser expects a C string
+inline auto make_input(const std::uint8_t* data, std::size_t size) -> std::string {
+    std::string s { reinterpret_cast<const char*>(data), size };
+    s.resize(std::strlen(s.c_str()));
+    return s;
+}
+
+// structural equality used by the differential checks, tolerance allows for engines with their own float conversion
+inline auto same_tree(const json5::value& a, const json5::value& b, double tolerance = 0.0) -> bool {
+    // packed and node arrays with the same elements are the same tree
+    if (a.is_array() && b.is_array()) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.size(); i++) {
+            if (!same_tree(a.at(i), b.at(i), tolerance)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (a._value.index() != b._value.index()) {
+        return false;
+    } else if (a.is_boolean()) {
+        return a.get<bool>() == b.get<bool>();
+    } else if (a.is_number_integer()) {
+        return a.get<std::int64_t>() == b.get<std::int64_t>();
+    } else if (a.is_number()) {
+        const auto x = a.get<double>();
+        const auto y = b.get<double>();
+        return x == y || (x != x && y != y) || std::fabs(x - y) <= tolerance * std::fabs(x);
+    } else if (a.is_string()) {
+        return a.get<std::string>() == b.get<std::string>();
+    } else if (a.is_object()) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.size(); i++) {
+            if (std::next(std::get<json5::value::object_type>(a._value).begin(), static_cast<std::ptrdiff_t>(i))->first
+                    != std::next(std::get<json5::value::object_type>(b._value).begin(), static_cast<std::ptrdiff_t>(i))->first) {
+                return false;
+            }
+            if (!same_tree(*a.find(i), *b.find(i), tolerance)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// merge patches cannot express members that are null
+inline auto has_null_member(const json5::value& v) -> bool {
+    for (std::size_t i = 0; i < v.size(); i++) {
+        const auto child = v.find(i);
+        if (child && ((v.is_object() && child->is_null()) || has_null_member(*child))) {
+            return true;
+        }
+    }
+
+    return false;
+}
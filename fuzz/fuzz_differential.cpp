@@ -0,0 +1,131 @@
+#include "common.hpp"
+
+#include <json5/batch.hpp>
+#include <json5/incremental.hpp>
+#include <json5/literal.hpp>
+#include <json5/patch.hpp>
+#include <json5/persistent.hpp>
+#include <json5/projection.hpp>
+#include <json5/schema.hpp>
+#include <json5/stream.hpp>
+
+// every engine is checked against the reference tree parser json5::value::parse
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    const auto input = make_input(data, size);
+    const auto reference = json5::value::parse(input);
+
+    // persistent values must round trip, with equal trees hashing alike in both representations
+    const auto persistent = json5::persistent_value::from_value(reference);
+    const auto round_trip = persistent.to_value();
+    if (!same_tree(reference, round_trip) || reference != round_trip || reference.hash() != round_trip.hash()
+        || persistent.hash() != reference.hash()) {
+        __builtin_trap();
+    }
+
+    // packed storage is only a representation, the tree stays equal
+    const auto packed = json5::value::parse(input, json5::parse_options { true });
+    if (packed != reference || packed.hash() != reference.hash()) {
+        __builtin_trap();
+    }
+
+    // a schema accepting anything must build the same tree
+    static const json5::schema any;
+    if (const auto validated = any.parse(input); validated && !same_tree(reference, *validated)) {
+        __builtin_trap();
+    }
+
+    // a well-formed single line record is parsed exactly like the whole input, a malformed one yields null
+    if (input.find('\n') == std::string::npos) {
+        std::vector<std::string_view> lines;
+        std::vector<std::size_t> malformed;
+        std::vector<json5::value> records;
+        if (json5::split_records(input, lines, &malformed) == 1 && json5::batch_parser::parse(input, records) == 1
+            && !same_tree(malformed.empty() ? reference : json5::value {}, records[0])) {
+            __builtin_trap();
+        }
+    }
+
+    // whatever the stream parser accepts as a single value, fed in small chunks, must agree
+    {
+        json5::stream_parser stream;
+        for (std::size_t i = 0; i < input.size(); i += 3) {
+            stream.feed(std::string_view { input }.substr(i, 3));
+        }
+        stream.finish();
+        if (!stream.failed() && stream.ready() == 1 && *stream.next() != reference) {
+            __builtin_trap();
+        }
+    }
+
+    // an incremental document edited anywhere must hold the tree of its whole source
+    if (!input.empty()) {
+        json5::incremental_document doc { input };
+        for (std::size_t i = 0; i + 2 < input.size() && i < 12; i += 3) {
+            const auto offset = static_cast<unsigned char>(input[i]) % (doc.source().size() + 1);
+            const auto length = static_cast<unsigned char>(input[i + 1]) % 4;
+            const auto text = std::string_view { input }.substr(static_cast<unsigned char>(input[i + 2]) % input.size(), length + 1);
+            doc.edit(offset, length, text);
+            if (doc.root() != json5::value::parse(doc.source())) {
+                __builtin_trap();
+            }
+        }
+    }
+
+    // the constexpr parser is stricter, whatever it accepts must agree; it does not decode escapes
+    if (input.find('\\') == std::string::npos) {
+        try {
+            std::vector<json5::static_node> nodes(json5::static_node_count(input));
+            json5::detail::static_parser { input, nodes.data() }.parse();
+            if (!same_tree(reference, json5::static_value { nodes.data(), 0 }.to_value(), 1e-15)) {
+                __builtin_trap();
+            }
+
+            // on well-formed input a projection of every other member matches the full parse
+            if (reference.is_object()) {
+                json5::projection selection;
+                const auto& members = std::get<json5::value::object_type>(reference._value);
+                std::size_t i = 0;
+                for (const auto& [k, v] : members) {
+                    if (i++ % 2 == 0) {
+                        selection.add(k);
+                    }
+                }
+                const auto projected = selection.parse(input);
+                i = 0;
+                for (const auto& [k, v] : members) {
+                    if (i++ % 2 == 0 && (!projected.find(k) || *projected.find(k) != v)) {
+                        __builtin_trap();
+                    }
+                }
+                if (projected.size() != (members.size() + 1) / 2) {
+                    __builtin_trap();
+                }
+            }
+        } catch (const std::invalid_argument&) {
+        }
+    }
+
+    // a diff between both halves of the input must turn one into the other
+    if (const auto half = input.find('\n'); half != std::string::npos) {
+        const auto from = json5::value::parse(input.substr(0, half));
+        const auto to = json5::value::parse(input.substr(half + 1));
+        const auto patched = json5::apply_patch(from, json5::diff(from, to));
+        if (!patched || !same_tree(*patched, to) || *patched != to || patched->hash() != to.hash()) {
+            __builtin_trap();
+        }
+
+        // snapshots produce the same patch as the values they hold
+        if (json5::diff(json5::persistent_value::from_value(from), json5::persistent_value::from_value(to)) != json5::diff(from, to)) {
+            __builtin_trap();
+        }
+
+        // merge patches remove members set to null instead of keeping them
+        auto merged = from;
+        json5::apply_merge_patch(merged, json5::merge_diff(from, to));
+        if (!has_null_member(to) && !same_tree(merged, to)) {
+            __builtin_trap();
+        }
+    }
+
+    return 0;
+}
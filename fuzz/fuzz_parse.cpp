@@ -0,0 +1,7 @@
+#include "common.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    const auto input = make_input(data, size);
+    json5::value::parse(input);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include "common.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    const auto input = make_input(data, size);
+    const char* p = input.c_str();
+    json5::value val;
+    json5::value::parse_number(&p, val);
+    if (p < input.c_str() || p > input.c_str() + input.size()) {
+        __builtin_trap();
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+#include "common.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    const auto input = make_input(data, size);
+    if (input.empty() || (input[0] != '"' && input[0] != '\'')) {
+        return 0;
+    }
+
+    const char* p = input.c_str();
+    json5::value val;
+    json5::value::parse_string(&p, val);
+    if (p < input.c_str() || p > input.c_str() + input.size()) {
+        __builtin_trap();
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include "common.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    const auto input = make_input(data, size);
+    const auto end = input.c_str() + input.size();
+
+    // the skipper must stay inside the input and make progress on every value it accepts
+    const char* p = input.c_str();
+    while (*p) {
+        const auto b = p;
+        json5::value::skip_value(&p);
+        if (p < b || p > end) {
+            __builtin_trap();
+        }
+        if (p == b) {
+            p++;
+        }
+    }
+
+    return 0;
+}
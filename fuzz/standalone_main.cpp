@@ -0,0 +1,36 @@
+// Replays inputs through a fuzz target when libFuzzer is not available
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size);
+
+static auto run_file(const std::filesystem::path& path) {
+    std::ifstream fs(path, std::ios::in | std::ios::binary);
+    const std::vector<char> contents { std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>() };
+    LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(contents.data()), contents.size());
+}
+
+int main(int argc, char** argv) {
+    std::size_t runs = 0;
+    for (int i = 1; i < argc; i++) {
+        const std::filesystem::path path { argv[i] };
+        if (std::filesystem::is_directory(path)) {
+            for (const auto& entry : std::filesystem::directory_iterator(path)) {
+                run_file(entry.path());
+                runs++;
+            }
+        } else {
+            run_file(path);
+            runs++;
+        }
+    }
+
+    std::cout << "Executed " << runs << " inputs" << std::endl;
+    return 0;
+}
@@ -0,0 +1,36 @@
+// Parser throughput gate, fails when parsing is slower than the given MB/s
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <json5/json5.hpp>
+
+static auto make_document(std::size_t records) {
+    std::string doc = "[\n";
+    for (std::size_t i = 0; i < records; i++) {
+        doc += "  { id: " + std::to_string(i) + ", name: 'record " + std::to_string(i)
+            + "', ratio: 0.125, enabled: true, tags: ['a', 'b', 'c'], /* note */ nested: { x: -1, y: 0x1F } },\n";
+    }
+    doc += "]\n";
+    return doc;
+}
+
+int main(int argc, char** argv) {
+    const auto min_mbps = argc > 1 ? std::atof(argv[1]) : 0.0;
+    const auto doc = make_document(20000);
+
+    constexpr auto iterations = 5;
+    std::size_t elements = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        elements += json5::value::parse(doc).size();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const auto mbps = static_cast<double>(doc.size() * iterations) / (1024.0 * 1024.0) / elapsed.count();
+    std::cout << "Parsed " << elements << " records at " << mbps << " MB/s (minimum " << min_mbps << " MB/s)" << std::endl;
+
+    return mbps >= min_mbps ? 0 : 1;
+}
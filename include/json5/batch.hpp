@@ -0,0 +1,364 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <thread>
+
+namespace json5 {
+
+namespace detail {
+    enum scan_class : unsigned char {
+        scan_plain = 0,
+        scan_newline,
+        scan_quote,
+        scan_backslash,
+        scan_slash,
+        scan_star,
+        scan_open,
+        scan_close,
+        scan_space,
+    };
+
+    inline constexpr auto make_scan_table() {
+        std::array<unsigned char, 256> table {};
+        table[static_cast<unsigned char>('\n')] = scan_newline;
+        table[static_cast<unsigned char>('"')] = scan_quote;
+        table[static_cast<unsigned char>('\'')] = scan_quote;
+        table[static_cast<unsigned char>('\\')] = scan_backslash;
+        table[static_cast<unsigned char>('/')] = scan_slash;
+        table[static_cast<unsigned char>('*')] = scan_star;
+        table[static_cast<unsigned char>('{')] = scan_open;
+        table[static_cast<unsigned char>('[')] = scan_open;
+        table[static_cast<unsigned char>('}')] = scan_close;
+        table[static_cast<unsigned char>(']')] = scan_close;
+        table[static_cast<unsigned char>(' ')] = scan_space;
+        table[static_cast<unsigned char>('\t')] = scan_space;
+        table[static_cast<unsigned char>('\r')] = scan_space;
+        table[static_cast<unsigned char>('\v')] = scan_space;
+        table[static_cast<unsigned char>('\f')] = scan_space;
+        return table;
+    }
+
+    inline constexpr auto scan_table = make_scan_table();
+} // namespace detail
+
+///
+/// Resumable scanner for record boundaries
+///
+/// Every record is a single line: a newline ends the record once it has some
+/// content, even inside an unterminated string, comment or bracket, so one
+/// malformed line never swallows the following records. malformed() tells
+/// whether the record just ended, or the one in progress, leaves such a
+/// construct open. The scanner keeps its state between calls, so input may
+/// be fed in arbitrary chunks.
+///
+class record_scanner {
+public:
+    /// returns the newline terminating the current record or nullptr if more input is needed
+    auto scan(const char* b, const char* e) -> const char* {
+        if (_ended) {
+            reset();
+        }
+
+        for (auto p = b; p != e; ++p) {
+            const auto cls = detail::scan_table[static_cast<unsigned char>(*p)];
+
+            if (cls == detail::scan_newline) {
+                if (_has_content) {
+                    _ended = true;
+                    return p;
+                }
+
+                // a line without a record, e.g. a comment, starts over as well
+                reset();
+                continue;
+            }
+
+            switch (_state) {
+            case state::plain:
+                if (_pending_slash && cls != detail::scan_slash && cls != detail::scan_star) {
+                    _pending_slash = false;
+                }
+                switch (cls) {
+                case detail::scan_plain:
+                    _has_content = true;
+                    // fast path for keys, literals and numbers
+                    while (p + 1 != e && detail::scan_table[static_cast<unsigned char>(*(p + 1))] == detail::scan_plain) {
+                        ++p;
+                    }
+                    break;
+                case detail::scan_space:
+                    break;
+                case detail::scan_quote:
+                    _has_content = true;
+                    _quote = *p;
+                    _state = state::string;
+                    break;
+                case detail::scan_slash:
+                    if (_pending_slash) {
+                        _pending_slash = false;
+                        _state = state::line_comment;
+                    } else {
+                        _pending_slash = true;
+                    }
+                    break;
+                case detail::scan_star:
+                    if (_pending_slash) {
+                        _pending_slash = false;
+                        _state = state::block_comment;
+                    } else {
+                        _has_content = true;
+                    }
+                    break;
+                case detail::scan_open:
+                    _has_content = true;
+                    _depth++;
+                    break;
+                case detail::scan_close:
+                    _has_content = true;
+                    if (_depth > 0) {
+                        _depth--;
+                    } else {
+                        _unbalanced = true;
+                    }
+                    break;
+                default:
+                    _has_content = true;
+                }
+                break;
+            case state::string:
+                if (_escape) {
+                    _escape = false;
+                } else if (cls == detail::scan_backslash) {
+                    _escape = true;
+                } else if (*p == _quote) {
+                    _state = state::plain;
+                }
+                break;
+            case state::line_comment:
+                break;
+            case state::block_comment:
+                if (cls == detail::scan_star) {
+                    _pending_star = true;
+                } else if (_pending_star && cls == detail::scan_slash) {
+                    _pending_star = false;
+                    _state = state::plain;
+                } else {
+                    _pending_star = false;
+                }
+                break;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// true if the input scanned since the last boundary holds a record
+    bool has_content() const noexcept {
+        return _has_content && !_ended;
+    }
+
+    /// true if the record leaves a string, block comment or bracket open, or closes a bracket it never opened
+    bool malformed() const noexcept {
+        return _state == state::string || _state == state::block_comment || _depth != 0 || _unbalanced;
+    }
+
+    void reset() noexcept {
+        *this = record_scanner {};
+    }
+
+private:
+    enum class state : unsigned char { plain, string, line_comment, block_comment };
+
+    state _state = state::plain;
+    char _quote = 0;
+    bool _escape = false;
+    bool _pending_slash = false;
+    bool _pending_star = false;
+    bool _has_content = false;
+    bool _unbalanced = false;
+    bool _ended = false;
+    std::size_t _depth = 0;
+};
+
+///
+/// Splits a buffer of newline delimited JSON5 documents into records
+///
+/// The indices of malformed records are appended to malformed when given.
+///
+inline auto split_records(std::string_view buf, std::vector<std::string_view>& records, std::vector<std::size_t>* malformed = nullptr)
+    -> std::size_t {
+    records.clear();
+
+    record_scanner scanner;
+    auto b = std::data(buf);
+    const auto e = b + std::size(buf);
+    const auto add = [&](const char* last) {
+        if (malformed && scanner.malformed()) {
+            malformed->push_back(std::size(records));
+        }
+        records.emplace_back(b, static_cast<std::size_t>(last - b));
+    };
+
+    while (b != e) {
+        const auto nl = scanner.scan(b, e);
+        if (!nl) {
+            break;
+        }
+        add(nl);
+        b = nl + 1;
+    }
+
+    if (scanner.has_content()) {
+        add(e);
+    }
+
+    return std::size(records);
+}
+
+///
+/// Batch parsing of newline delimited JSON5 documents
+///
+/// Records are single lines. A malformed record, see record_scanner, yields
+/// a null value in its place and the following records are unaffected.
+///
+template <typename JsonValue> struct basic_batch_parser {
+    using value_type = JsonValue;
+    using container_type = std::vector<value_type>;
+
+private:
+    /// joins every started thread, also when starting another one throws
+    struct thread_joiner {
+        ~thread_joiner() {
+            for (auto& t : pool) {
+                if (t.joinable()) {
+                    t.join();
+                }
+            }
+        }
+
+        std::vector<std::thread>& pool;
+    };
+
+public:
+
+    /// parses a single record, scratch keeps the record null terminated for the parser
+    static auto parse_record(std::string_view record, std::string& scratch) -> value_type {
+        scratch.assign(std::data(record), std::size(record));
+        return value_type::parse(scratch);
+    }
+
+    /// calls f(index, value) for every record in order
+    template <typename Callback> static auto for_each(std::string_view buf, Callback&& f) -> std::size_t {
+        record_scanner scanner;
+        std::string scratch;
+        std::size_t count = 0;
+
+        auto b = std::data(buf);
+        const auto e = b + std::size(buf);
+        while (b != e) {
+            const auto nl = scanner.scan(b, e);
+            if (!nl) {
+                break;
+            }
+            f(count++, scanner.malformed() ? value_type {} : parse_record({ b, static_cast<std::size_t>(nl - b) }, scratch));
+            b = nl + 1;
+        }
+
+        if (scanner.has_content()) {
+            f(count++, scanner.malformed() ? value_type {} : parse_record({ b, static_cast<std::size_t>(e - b) }, scratch));
+        }
+
+        return count;
+    }
+
+    /// parses all records into out, reusing its storage; records keep their order for any thread count
+    static auto parse(std::string_view buf, container_type& out, unsigned threads = 1) -> std::size_t {
+        std::vector<std::string_view> records;
+        std::vector<std::size_t> malformed;
+        split_records(buf, records, &malformed);
+
+        // an empty record parses to null
+        for (const auto i : malformed) {
+            records[i] = {};
+        }
+
+        out.resize(std::size(records));
+
+        const auto count = std::size(records);
+        const auto workers = std::max<std::size_t>(1, std::min<std::size_t>(threads, count));
+
+        const auto parse_range = [&records, &out](std::size_t first, std::size_t last) {
+            std::string scratch;
+            for (auto i = first; i < last; i++) {
+                out[i] = parse_record(records[i], scratch);
+            }
+        };
+
+        if (workers == 1) {
+            parse_range(0, count);
+            return count;
+        }
+
+        // an exception on any thread, the calling one included, is rethrown once all workers have finished
+        std::vector<std::exception_ptr> errors(workers);
+        const auto run = [&parse_range, &errors](std::size_t w, std::size_t first, std::size_t last) {
+            try {
+                parse_range(first, last);
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        };
+
+        {
+            std::vector<std::thread> pool;
+            const thread_joiner joiner { pool };
+            pool.reserve(workers - 1);
+
+            const auto chunk = (count + workers - 1) / workers;
+            for (std::size_t w = 1; w < workers; w++) {
+                const auto first = std::min(count, w * chunk);
+                pool.emplace_back(run, w, first, std::min(count, first + chunk));
+            }
+            run(0, 0, std::min(count, chunk));
+        }
+
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        return count;
+    }
+};
+
+using batch_parser = basic_batch_parser<value>;
+
+} // namespace json5
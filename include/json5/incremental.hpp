@@ -0,0 +1,284 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+
+namespace json5 {
+
+///
+/// Document that re-parses only the edited part of its source
+///
+/// Every object and array remembers where it is in the source. An edit is
+/// re-parsed from the smallest enclosing object or array and the result is
+/// spliced into the existing tree, all other subtrees stay in place. Edits that
+/// touch the brackets of the root or leave the re-parsed text unbalanced fall
+/// back to parsing the whole source.
+///
+template <typename JsonValue> class basic_incremental_document {
+public:
+    using value_type = JsonValue;
+    using string_type = typename value_type::string_type;
+    using string_view_type = typename value_type::string_view_type;
+    using object_type = typename value_type::object_type;
+    using array_type = typename value_type::array_type;
+    using size_type = std::size_t;
+
+    explicit basic_incremental_document(string_type source)
+        : _source { std::move(source) } {
+        parse_all();
+    }
+
+    auto source() const -> const string_type& {
+        return _source;
+    }
+
+    auto root() const -> const value_type& {
+        return _root;
+    }
+
+    /// replaces length bytes at offset with text, returns false if the whole document had to be parsed again
+    auto edit(size_type offset, size_type length, string_view_type text) -> bool {
+        offset = std::min(offset, _source.size());
+        length = std::min(length, _source.size() - offset);
+
+        _source.replace(offset, length, text.data(), text.size());
+
+        if (reparse_enclosing(offset, length, text.size())) {
+            return true;
+        }
+
+        parse_all();
+        return false;
+    }
+
+private:
+    struct span_node {
+        size_type begin = 0; // relative to the begin of the parent
+        size_type end = 0;
+        string_type key;
+        size_type index = 0;
+        std::vector<span_node> children; // objects and arrays only
+    };
+
+    void parse_all() {
+        _root = value_type::parse(_source);
+        _spans = span_node {};
+        if (!scan_document(_source.c_str(), _spans)) {
+            _spans = span_node {};
+        }
+    }
+
+    static auto is_container(char ch) -> bool {
+        return ch == '{' || ch == '[';
+    }
+
+    static auto scan_document(const char* base, span_node& node) -> bool {
+        const char* p = base;
+        value_type::skip_spaces_and_comments(&p);
+        if (!is_container(*p)) {
+            return false;
+        }
+
+        node.begin = static_cast<size_type>(p - base);
+        if (!scan(base, &p, node.begin, node)) {
+            return false;
+        }
+
+        node.end = static_cast<size_type>(p - base);
+        value_type::skip_spaces_and_comments(&p);
+        return *p == '\0';
+    }
+
+    /// records the spans of all nested containers, *p is at the opening bracket and self is its absolute offset
+    static auto scan(const char* base, const char** p, size_type self, span_node& node) -> bool {
+        const auto close = **p == '{' ? '}' : ']';
+        size_type index = 0;
+        std::set<string_type, std::less<>> keys;
+
+        (*p)++;
+
+        while (true) {
+            value_type::skip_spaces_and_comments(p);
+
+            if (**p == close) {
+                (*p)++;
+                return true;
+            } else if (**p == ',') {
+                (*p)++;
+                continue;
+            } else if (**p == '\0' || **p == ']' || **p == '}') {
+                return false;
+            }
+
+            span_node child;
+            if (close == '}') {
+                child.key = value_type::parse_key(p);
+                if (std::empty(child.key) || **p != ':') {
+                    return false;
+                }
+                (*p)++;
+                value_type::skip_spaces_and_comments(p);
+            }
+
+            // the first occurrence of a key wins, later ones are parsed but not recorded
+            const auto duplicate = close == '}' && !keys.insert(child.key).second;
+
+            if (!is_container(**p)) {
+                // scalars go through the parser itself so that elements are counted the same way
+                const auto b = *p;
+                value_type scalar;
+                value_type::parse_value(p, scalar);
+                if (*p == b) {
+                    if (close == '}') {
+                        return false;
+                    }
+                    (*p)++;
+                } else {
+                    index++;
+                }
+                continue;
+            }
+
+            child.index = index++;
+
+            const auto child_self = static_cast<size_type>(*p - base);
+            child.begin = child_self - self;
+            if (!scan(base, p, child_self, child)) {
+                return false;
+            }
+            child.end = static_cast<size_type>(*p - base) - self;
+
+            if (!duplicate) {
+                node.children.push_back(std::move(child));
+            }
+        }
+    }
+
+    auto reparse_enclosing(size_type offset, size_type removed, size_type inserted) -> bool {
+        if (_spans.end == 0) {
+            return false;
+        }
+
+        // path from the root to the smallest container strictly enclosing the edited range
+        std::vector<span_node*> path { &_spans };
+        auto abs_begin = _spans.begin;
+
+        if (offset <= abs_begin || offset + removed >= _spans.end) {
+            return false;
+        }
+
+        while (true) {
+            // children are in source order, only the last one starting before the edit can enclose it
+            auto& children = path.back()->children;
+            const auto after = std::partition_point(
+                children.begin(), children.end(), [&](const span_node& child) { return abs_begin + child.begin < offset; });
+            if (after == children.begin()) {
+                break;
+            }
+            auto& child = *std::prev(after);
+            if (offset + removed >= abs_begin + child.end) {
+                break;
+            }
+            abs_begin += child.begin;
+            path.push_back(&child);
+        }
+
+        auto& node = *path.back();
+        const auto old_length = node.end - node.begin;
+        const auto new_length = old_length - removed + inserted;
+
+        // the enclosing container is parsed again on its own and must be balanced
+        const string_type region { _source.data() + abs_begin, new_length };
+        span_node spans;
+        spans.begin = 0;
+        if (!scan_document(region.c_str(), spans) || spans.begin != 0 || spans.end != new_length) {
+            return false;
+        }
+
+        auto* target = &_root;
+        for (size_type i = 1; i < path.size(); i++) {
+            if (target->is_object()) {
+                auto& obj = std::get<object_type>(target->_value);
+                auto it = obj.find(path[i]->key);
+                if (it == obj.end()) {
+                    return false;
+                }
+                target = &it->second;
+            } else if (std::holds_alternative<array_type>(target->_value)) {
+                auto& arr = std::get<array_type>(target->_value);
+                if (path[i]->index >= arr.size()) {
+                    return false;
+                }
+                target = &arr[path[i]->index];
+            } else {
+                return false;
+            }
+        }
+
+        // lenient recovery from malformed input depends on what follows, so the region has to parse on its own
+        value_type val;
+        const char* p = region.c_str();
+        value_type::parse_value(&p, val);
+        if (static_cast<size_type>(p - region.c_str()) != new_length) {
+            return false;
+        }
+
+        *target = std::move(val);
+
+        // splice the new spans and shift everything behind the edit
+        spans.begin = node.begin;
+        spans.end = node.begin + new_length;
+        spans.key = std::move(node.key);
+        spans.index = node.index;
+        node = std::move(spans);
+
+        const auto shift = [inserted, removed](size_type& v) { v = v + inserted - removed; };
+        for (auto i = path.size() - 1; i > 0; i--) {
+            auto* parent = path[i - 1];
+            const auto child_begin = path[i]->begin;
+            for (auto& sibling : parent->children) {
+                if (sibling.begin > child_begin) {
+                    shift(sibling.begin);
+                    shift(sibling.end);
+                }
+            }
+            shift(parent->end);
+        }
+
+        return true;
+    }
+
+    string_type _source;
+    value_type _root;
+    span_node _spans;
+};
+
+using incremental_document = basic_incremental_document<value>;
+
+} // namespace json5
@@ -28,6 +28,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <map>
 #include <string>
@@ -38,6 +39,14 @@
 
 #include <iostream>
 
+#if defined(JSON5_ENABLE_STATS)
+#include <algorithm>
+#include <chrono>
+#define JSON5_STATS(...) __VA_ARGS__
+#else
+#define JSON5_STATS(...)
+#endif
+
 namespace json5 {
 
 // https://semver.org/
@@ -75,11 +84,255 @@ namespace detail {
 
         return false;
     }
+
+    template <typename T, typename = void> struct is_allocator_aware : std::false_type { };
+
+    template <typename T> struct is_allocator_aware<T, std::void_t<typename T::allocator_type>> : std::true_type { };
+
+    /// constructs a container, allocator aware containers get alloc converted to their own allocator type
+    template <typename T, typename Allocator, typename... Args> auto construct_with(const Allocator& alloc, Args&&... args) -> T {
+        if constexpr (std::uses_allocator_v<T, Allocator>) {
+            return T(std::forward<Args>(args)..., typename T::allocator_type { alloc });
+        } else {
+            return T(std::forward<Args>(args)...);
+        }
+    }
+
+    /// copies a container into the allocator of the original, which a plain copy does not do for every allocator
+    template <typename T> auto copy_container(const T& c) -> T {
+        if constexpr (is_allocator_aware<T>::value) {
+            return T(c, c.get_allocator());
+        } else {
+            return c;
+        }
+    }
+
+    // structural hashing, stable across runs and platforms
+    enum hash_tag : std::uint64_t { hash_null = 1, hash_boolean, hash_string, hash_number, hash_int, hash_object, hash_array };
+
+    constexpr auto hash_mix(std::uint64_t x) -> std::uint64_t {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    constexpr auto hash_combine(std::uint64_t seed, std::uint64_t v) -> std::uint64_t {
+        return hash_mix(seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+    }
+
+    inline auto hash_bytes(const char* p, std::size_t n) -> std::uint64_t {
+        std::uint64_t h = hash_mix(n);
+        for (; n >= 8; p += 8, n -= 8) {
+            std::uint64_t word = 0;
+            for (int i = 7; i >= 0; i--) {
+                word = (word << 8) | static_cast<unsigned char>(p[i]);
+            }
+            h = hash_combine(h, word);
+        }
+        std::uint64_t tail = 0;
+        for (std::size_t i = n; i > 0; i--) {
+            tail = (tail << 8) | static_cast<unsigned char>(p[i - 1]);
+        }
+        return hash_combine(h, tail);
+    }
+
+    constexpr auto hash_scalar(bool v) -> std::uint64_t {
+        return hash_combine(hash_boolean, v ? 1 : 0);
+    }
+
+    constexpr auto hash_scalar(std::int64_t v) -> std::uint64_t {
+        return hash_combine(hash_int, static_cast<std::uint64_t>(v));
+    }
+
+    /// -0.0 hashes like 0.0 and all NaNs alike, matching equality
+    inline auto hash_scalar(double v) -> std::uint64_t {
+        std::uint64_t bits = 0;
+        if (v != v) {
+            bits = 0x7ff8000000000000ULL;
+        } else if (v != 0.0) {
+            std::memcpy(&bits, &v, sizeof(bits));
+        }
+        return hash_combine(hash_number, bits);
+    }
+
+    template <typename String> auto hash_string_value(const String& str) -> std::uint64_t {
+        return hash_combine(hash_string, hash_bytes(std::data(str), std::size(str)));
+    }
+
+    /// members are summed, so the hash of an object does not depend on their order
+    constexpr auto hash_member(std::uint64_t key, std::uint64_t value) -> std::uint64_t {
+        return hash_mix(hash_combine(key, value));
+    }
+
+    constexpr auto hash_container(hash_tag tag, std::uint64_t acc, std::size_t size) -> std::uint64_t {
+        return hash_combine(hash_combine(tag, acc), size);
+    }
+} // namespace detail
+
+///
+/// Parser options
+///
+/// pack_arrays stores arrays whose elements are all integers, all floating
+/// point numbers or all booleans packed, without a node per element. Packing
+/// saves memory, but find(idx) and std::get<array_type> no longer reach the
+/// elements of such arrays, so it is off unless asked for.
+///
+struct parse_options {
+    bool pack_arrays = false;
+};
+
+#if defined(JSON5_ENABLE_STATS)
+///
+/// Parser statistics, only available when built with JSON5_ENABLE_STATS
+///
+/// The allocation fields are estimates, not counts: they are derived from the
+/// capacity of the strings and arrays the parser creates and from a typical
+/// node size for object members, without looking at the allocator. Structural
+/// time is the parse time not spent in string or number handling.
+///
+struct parse_stats {
+    std::size_t bytes_scanned = 0;
+    std::size_t nulls = 0;
+    std::size_t booleans = 0;
+    std::size_t strings = 0;
+    std::size_t keys = 0;
+    std::size_t integers = 0;
+    std::size_t numbers = 0;
+    std::size_t objects = 0;
+    std::size_t arrays = 0;
+    std::size_t estimated_allocations = 0;
+    std::size_t estimated_bytes_allocated = 0;
+    std::size_t max_depth = 0;
+    std::chrono::nanoseconds string_time {};
+    std::chrono::nanoseconds number_time {};
+    std::chrono::nanoseconds structural_time {};
+};
+
+/// called on the parsing thread after every parse()
+inline auto stats_callback() -> std::function<void(const parse_stats&)>& {
+    static std::function<void(const parse_stats&)> callback;
+    return callback;
+}
+
+namespace detail {
+    inline auto current_stats() -> parse_stats& {
+        thread_local parse_stats stats;
+        return stats;
+    }
+
+    inline auto current_depth() -> std::size_t& {
+        thread_local std::size_t depth = 0;
+        return depth;
+    }
+
+    struct stats_timer {
+        explicit stats_timer(std::chrono::nanoseconds& t)
+            : total { t } {
+        }
+
+        ~stats_timer() {
+            total += std::chrono::steady_clock::now() - start;
+        }
+
+        std::chrono::nanoseconds& total;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+
+    struct stats_depth {
+        stats_depth() {
+            auto& stats = current_stats();
+            stats.max_depth = std::max(stats.max_depth, ++current_depth());
+        }
+
+        ~stats_depth() {
+            --current_depth();
+        }
+    };
+
+    /// tree links and colour of a map node in common standard libraries
+    constexpr std::size_t estimated_node_overhead = 4 * sizeof(void*);
+
+    inline auto count_allocation(std::size_t bytes) {
+        auto& stats = current_stats();
+        stats.estimated_allocations++;
+        stats.estimated_bytes_allocated += bytes;
+    }
+
+    template <typename String> inline auto count_string_allocation(const String& str) {
+        if (str.capacity() > String {}.capacity()) {
+            count_allocation((str.capacity() + 1) * sizeof(typename String::value_type));
+        }
+    }
 } // namespace detail
 
+/// statistics of the last parse() on the calling thread
+inline auto last_parse_stats() -> parse_stats {
+    return detail::current_stats();
+}
+#endif
+
+///
+/// Contiguous read-only view of packed array storage
+///
+template <typename T> class span {
+public:
+    using element_type = T;
+    using size_type = std::size_t;
+
+    constexpr span() = default;
+
+    constexpr span(T* data, size_type size)
+        : _data { data }
+        , _size { size } {
+    }
+
+    constexpr auto data() const noexcept -> T* {
+        return _data;
+    }
+
+    constexpr auto size() const noexcept -> size_type {
+        return _size;
+    }
+
+    constexpr bool empty() const noexcept {
+        return _size == 0;
+    }
+
+    constexpr auto begin() const noexcept -> T* {
+        return _data;
+    }
+
+    constexpr auto end() const noexcept -> T* {
+        return _data + _size;
+    }
+
+    constexpr auto operator[](size_type idx) const -> T& {
+        return _data[idx];
+    }
+
+private:
+    T* _data = nullptr;
+    size_type _size = 0;
+};
+
 ///
 /// JSON5 value
 ///
+/// When parsed with parse_options::pack_arrays, arrays whose elements are all
+/// integers, all floating point numbers or all booleans are stored packed,
+/// without a node per element. They behave like any other array, except that
+/// find() has no element node to point to; unpack() converts them back.
+///
+/// Strings and containers created by parse() use the allocator passed to it,
+/// copies use the allocator of the original.
+///
+/// All const member functions only read the tree, so a value that is no longer
+/// modified may be shared between any number of reader threads. Use find() for
+/// reference access without copying subtrees.
+///
 template <template <typename... Args> typename VariantType = std::variant,
     template <typename U, typename V, typename... Args> typename ObjectType = std::map,
     template <typename U, typename... Args> typename DynArrayType = std::vector, typename StringType = std::string,
@@ -97,7 +350,14 @@ public:
     using number_type = NumberFloatType;
     using int_type = NumberIntType;
     using array_type = DynArrayType<value_type>;
-    using json_value = VariantType<null_type, boolean_type, string_type, number_type, int_type, object_type, array_type>;
+    using int_array_type = DynArrayType<int_type>;
+    using number_array_type = DynArrayType<number_type>;
+    using boolean_array_type = DynArrayType<boolean_type>;
+    using json_value = VariantType<null_type, boolean_type, string_type, number_type, int_type, object_type, array_type, int_array_type,
+        number_array_type, boolean_array_type>;
+
+    /// allocator handed to the parser, converted to the allocator type of every string and container it creates
+    using container_allocator_type = typename array_type::allocator_type;
 
     // ctor
 
@@ -115,7 +375,7 @@ public:
     }
 
     basic_json_value(string_type val)
-        : _value { val } {
+        : _value { std::move(val) } {
     }
 
     basic_json_value(int_type val)
@@ -127,13 +387,43 @@ public:
     }
 
     basic_json_value(object_type val)
-        : _value { val } {
+        : _value { std::move(val) } {
     }
 
-    basic_json_value(const array_type& val)
-        : _value { val } {
+    basic_json_value(array_type val)
+        : _value { std::move(val) } {
+    }
+
+    basic_json_value(int_array_type val)
+        : _value { std::move(val) } {
+    }
+
+    basic_json_value(number_array_type val)
+        : _value { std::move(val) } {
     }
 
+    basic_json_value(boolean_array_type val)
+        : _value { std::move(val) } {
+    }
+
+    /// copies keep the allocator of the original, see detail::copy_container
+    basic_json_value(const basic_json_value& other)
+        : _value { copy_value(other._value) } {
+    }
+
+    basic_json_value(basic_json_value&&) = default;
+
+    auto operator=(const basic_json_value& other) -> basic_json_value& {
+        if (this != &other) {
+            // other may be a child of this value
+            auto copy = copy_value(other._value);
+            _value = std::move(copy);
+        }
+        return *this;
+    }
+
+    auto operator=(basic_json_value&&) -> basic_json_value& = default;
+
     /// object inspection
 
     constexpr bool is_null() const noexcept {
@@ -160,13 +450,19 @@ public:
         return std::holds_alternative<object_type>(_value);
     }
 
+    /// true for packed arrays as well, which hold no array_type: call unpack() before std::get<array_type> or find(idx)
     constexpr bool is_array() const noexcept {
-        return std::holds_alternative<array_type>(_value);
+        return std::holds_alternative<array_type>(_value) || is_packed_array();
+    }
+
+    constexpr bool is_packed_array() const noexcept {
+        return std::holds_alternative<int_array_type>(_value) || std::holds_alternative<number_array_type>(_value)
+            || std::holds_alternative<boolean_array_type>(_value);
     }
 
     /// value access
 
-    template <typename T> constexpr auto get() -> T const {
+    template <typename T> constexpr auto get() const -> T {
         if constexpr (std::is_same_v<T, boolean_type>) {
             return static_cast<T>(std::get<boolean_type>(_value));
         } else if constexpr (std::is_integral_v<T>) {
@@ -227,6 +523,8 @@ public:
             auto it = std::get<object_type>(_value).begin();
             std::advance(it, idx);
             return it->second;
+        } else if (is_packed_array()) {
+            return packed_at(idx);
         }
 
         return basic_json_value { null_type {} };
@@ -239,6 +537,8 @@ public:
             auto it = std::get<object_type>(_value).begin();
             std::advance(it, idx);
             return it->second;
+        } else if (is_packed_array()) {
+            return packed_at(idx);
         }
 
         return basic_json_value { null_type {} };
@@ -250,11 +550,41 @@ public:
             if (idx < arr.size()) {
                 return arr[idx];
             }
+        } else if (is_packed_array() && idx < size()) {
+            return packed_at(idx);
         }
 
         return basic_json_value { null_type {} };
     }
 
+    /// node of an element or member, nullptr for the elements of a packed array which have no node until unpack()
+    auto find(size_type idx) const -> const basic_json_value* {
+        if (std::holds_alternative<array_type>(_value)) {
+            const auto& arr = std::get<array_type>(_value);
+            return idx < arr.size() ? &arr[idx] : nullptr;
+        } else if (std::holds_alternative<object_type>(_value)) {
+            const auto& obj = std::get<object_type>(_value);
+            if (idx < obj.size()) {
+                auto it = obj.begin();
+                std::advance(it, idx);
+                return &it->second;
+            }
+        }
+
+        return nullptr;
+    }
+
+    auto find(const typename object_type::key_type& key) const -> const basic_json_value* {
+        if (std::holds_alternative<object_type>(_value)) {
+            const auto& obj = std::get<object_type>(_value);
+            if (auto it = obj.find(key); it != obj.end()) {
+                return &it->second;
+            }
+        }
+
+        return nullptr;
+    }
+
     auto at(const typename object_type::key_type& key) {
         if (std::holds_alternative<object_type>(_value)) {
             return std::get<object_type>(_value).at(key);
@@ -292,11 +622,90 @@ public:
             return std::get<array_type>(_value).size();
         } else if (std::holds_alternative<object_type>(_value)) {
             return std::get<object_type>(_value).size();
+        } else if (std::holds_alternative<int_array_type>(_value)) {
+            return std::get<int_array_type>(_value).size();
+        } else if (std::holds_alternative<number_array_type>(_value)) {
+            return std::get<number_array_type>(_value).size();
+        } else if (std::holds_alternative<boolean_array_type>(_value)) {
+            return std::get<boolean_array_type>(_value).size();
         }
 
         return 0;
     }
 
+    /// packed array access
+
+    auto int_span() const -> span<const int_type> {
+        if (auto arr = std::get_if<int_array_type>(&_value); arr) {
+            return { std::data(*arr), std::size(*arr) };
+        }
+
+        return {};
+    }
+
+    auto number_span() const -> span<const number_type> {
+        if (auto arr = std::get_if<number_array_type>(&_value); arr) {
+            return { std::data(*arr), std::size(*arr) };
+        }
+
+        return {};
+    }
+
+    auto boolean_bits() const -> const boolean_array_type* {
+        return std::get_if<boolean_array_type>(&_value);
+    }
+
+    /// converts packed storage to an array of element nodes
+    void unpack() {
+        if (auto ints = std::get_if<int_array_type>(&_value); ints) {
+            _value = unpack_array(*ints);
+        } else if (auto numbers = std::get_if<number_array_type>(&_value); numbers) {
+            _value = unpack_array(*numbers);
+        } else if (auto booleans = std::get_if<boolean_array_type>(&_value); booleans) {
+            _value = unpack_array(*booleans);
+        }
+    }
+
+    /// comparison
+
+    /// structural equality, packed arrays equal arrays of the same elements and NaN equals NaN
+    friend bool operator==(const basic_json_value& a, const basic_json_value& b) {
+        return equal(a, b);
+    }
+
+    friend bool operator!=(const basic_json_value& a, const basic_json_value& b) {
+        return !equal(a, b);
+    }
+
+    /// stable 64-bit structural hash, independent of the order of object members
+    auto hash() const -> std::uint64_t {
+        if (auto b = std::get_if<boolean_type>(&_value); b) {
+            return detail::hash_scalar(*b);
+        } else if (auto s = std::get_if<string_type>(&_value); s) {
+            return detail::hash_string_value(*s);
+        } else if (auto n = std::get_if<number_type>(&_value); n) {
+            return detail::hash_scalar(static_cast<double>(*n));
+        } else if (auto i = std::get_if<int_type>(&_value); i) {
+            return detail::hash_scalar(static_cast<std::int64_t>(*i));
+        } else if (auto obj = std::get_if<object_type>(&_value); obj) {
+            std::uint64_t acc = 0;
+            for (const auto& [k, v] : *obj) {
+                acc += detail::hash_member(detail::hash_string_value(k), v.hash());
+            }
+            return detail::hash_container(detail::hash_object, acc, obj->size());
+        } else if (auto arr = std::get_if<array_type>(&_value); arr) {
+            return hash_elements(*arr, [](const auto& v) { return v.hash(); });
+        } else if (auto ints = std::get_if<int_array_type>(&_value); ints) {
+            return hash_elements(*ints, [](auto v) { return detail::hash_scalar(static_cast<std::int64_t>(v)); });
+        } else if (auto numbers = std::get_if<number_array_type>(&_value); numbers) {
+            return hash_elements(*numbers, [](auto v) { return detail::hash_scalar(static_cast<double>(v)); });
+        } else if (auto booleans = std::get_if<boolean_array_type>(&_value); booleans) {
+            return hash_elements(*booleans, [](bool v) { return detail::hash_scalar(v); });
+        }
+
+        return detail::hash_mix(detail::hash_null);
+    }
+
     /// dump
     string_type dump() {
         string_type s;
@@ -308,60 +717,36 @@ public:
 
     /// parser
     static auto skip_spaces_and_comments(const char** p) {
-        do {
-            const bool single_line_comment = **p == '/' && *((*p) + 1) == '/';
-            const bool multi_line_comment = **p == '/' && *((*p) + 1) == '*';
-            if (!isspace(**p) && !single_line_comment && !multi_line_comment) {
+        while (**p) {
+            if (isspace(static_cast<unsigned char>(**p))) {
+                (*p)++;
+            } else if (**p == '/' && *((*p) + 1) == '/') {
+                auto* e = strchr(*p, '\n');
+                *p = e ? e + 1 : *p + strlen(*p);
+            } else if (**p == '/' && *((*p) + 1) == '*') {
+                auto* e = strstr(*p + 2, "*/");
+                *p = e ? e + 2 : *p + strlen(*p);
+            } else {
                 break;
-            } else if (single_line_comment) {
-                if (auto* e = strchr(*p, '\n'); e) {
-                    (*p) += e - (*p);
-                }
-            } else if (multi_line_comment) {
-                do {
-                    (*p) += 2;
-                    if (auto* e = strchr(*p, '*'); e) {
-                        if (*(e + 1) == '/') {
-                            (*p) += e - (*p) + 1;
-                            break;
-                        } else {
-                            (*p) += e - (*p);
-                        }
-                    }
-
-                } while (**p);
             }
+        }
+    }
 
-            (*p)++;
+    static auto parse_string(const char** p, value_type& value, const container_allocator_type& alloc = {}) {
+        JSON5_STATS(const detail::stats_timer timer { detail::current_stats().string_time });
+        JSON5_STATS(detail::current_stats().strings++);
 
-        } while (**p);
+        auto res = read_string(p, alloc);
+        JSON5_STATS(detail::count_string_allocation(res));
+        value = std::move(res);
     }
 
-    static auto parse_string(const char** p, value_type& value) {
-        string_type res;
-        const auto quote = **p;
-        auto b = *p + 1;
-        auto e = b;
-        while (*e) {
-            if (*e == '\\' && *(e + 1) == quote) {
-                e += 2;
-                continue;
-            } else if (detail::is_escape(e)) {
-                res += *e;
-                e++;
-                continue;
-            } else if (*e == quote) {
-                break;
-            }
-            res += *e;
-            ++e;
-        }
-        value = res;
-        *p = e + 1;
-    }
+    static auto parse_array(
+        const char** p, value_type& value, const parse_options& options = {}, const container_allocator_type& alloc = {}) {
+        JSON5_STATS(const detail::stats_depth depth);
+        JSON5_STATS(detail::current_stats().arrays++);
 
-    static auto parse_array(const char** p, value_type& value) {
-        value = array_type {};
+        value = detail::construct_with<array_type>(alloc);
 
         (*p)++;
 
@@ -378,13 +763,37 @@ public:
                 break;
             }
 
-            auto& arr = std::get<array_type>(value._value);
-            arr.emplace_back(null_type {});
-            parse_value(p, arr.back());
+            if (**p == '\0') {
+                break;
+            }
+
+            const auto b = *p;
+
+            if (auto arr = std::get_if<array_type>(&value._value); arr && (!arr->empty() || !options.pack_arrays)) {
+                // nodes and mixed elements are parsed in place
+                push_element(*arr, null_type {});
+                parse_value(p, arr->back(), options, alloc);
+                if (*p == b) {
+                    // skip the unexpected character
+                    arr->pop_back();
+                    (*p)++;
+                }
+                continue;
+            }
+
+            value_type element;
+            parse_value(p, element, options, alloc);
+            if (*p == b) {
+                (*p)++;
+                continue;
+            }
+            append_element(value, std::move(element));
         }
     }
 
     static auto parse_boolean(const char** p, value_type& value) {
+        JSON5_STATS(detail::current_stats().booleans++);
+
         if (strncmp(*p, "true", 4) == 0) {
             value = true;
             *p += 4;
@@ -395,6 +804,8 @@ public:
     }
 
     static auto parse_null(const char** p, value_type& value) {
+        JSON5_STATS(detail::current_stats().nulls++);
+
         if (strncmp(*p, "null", 4) == 0) {
             *p += 4;
             value = null_type {};
@@ -402,6 +813,8 @@ public:
     }
 
     static auto parse_number(const char** p, value_type& value) {
+        JSON5_STATS(const detail::stats_timer timer { detail::current_stats().number_time });
+
         if (strncmp(*p, "NaN", 3) == 0) {
             *p += 3;
             value = std::numeric_limits<number_type>::quiet_NaN();
@@ -426,14 +839,14 @@ public:
             auto start = *p;
             if ((**p == '-') || (**p == '+') || (**p == '.') || isdigit(**p)) {
                 do {
-                    if (**p == '.') {
+                    if ((**p == '.') || (base == 10 && ((**p == 'e') || (**p == 'E')))) {
                         is_float_point = true;
                     }
                     if ((**p == 'x') || (**p == 'X')) {
                         base = 16;
                     }
                     (*p)++;
-                } while (isdigit(**p) || isxdigit(**p) || (**p == '.') || (**p == 'x'));
+                } while (isdigit(**p) || isxdigit(**p) || (**p == '.') || (**p == 'x') || (**p == 'X'));
             }
             char* end;
             if (is_float_point) {
@@ -441,35 +854,46 @@ public:
             } else {
                 value = static_cast<int_type>(strtoll(start, &end, base));
             }
+            if (end != start) {
+                // the conversion knows the exact end, e.g. for exponent signs
+                *p = end;
+            }
         }
+
+        JSON5_STATS(value.is_number_integer() ? detail::current_stats().integers++ : detail::current_stats().numbers++);
     }
 
-    static auto parse_key(const char** p) {
+    static auto parse_key(const char** p, const container_allocator_type& alloc = {}) {
+        if (**p == '"' || **p == '\'') {
+            JSON5_STATS(detail::current_stats().keys++);
+            auto key = read_string(p, alloc);
+            JSON5_STATS(detail::count_string_allocation(key));
+            skip_spaces_and_comments(p);
+            return key;
+        }
+
         if (isalpha(**p) || (**p == '_') || **p == '$') {
+            JSON5_STATS(detail::current_stats().keys++);
             auto b = *p;
             do {
                 (*p)++;
-            } while (**p && (**p == '_' || isalpha(**p) || isdigit(**p)));
-
-            if (**p == ':') {
-                return string_type { b, *p };
-            } else {
-                while (**p) {
-                    if (!isspace(**p) || **p == ':') {
-                        break;
-                    }
-                    (*p)++;
-                }
+            } while (**p && (**p == '_' || **p == '$' || isalpha(**p) || isdigit(**p)));
 
-                return string_type { b, *p };
-            }
+            auto key = detail::construct_with<string_type>(alloc, b, *p);
+            JSON5_STATS(detail::count_string_allocation(key));
+            skip_spaces_and_comments(p);
+            return key;
         }
 
-        return string_type {};
+        return detail::construct_with<string_type>(alloc);
     }
 
-    static auto parse_object(const char** p, value_type& value) {
-        value = object_type {};
+    static auto parse_object(
+        const char** p, value_type& value, const parse_options& options = {}, const container_allocator_type& alloc = {}) {
+        JSON5_STATS(const detail::stats_depth depth);
+        JSON5_STATS(detail::current_stats().objects++);
+
+        value = detail::construct_with<object_type>(alloc);
 
         while (true) {
             skip_spaces_and_comments(p);
@@ -478,34 +902,45 @@ public:
                 break;
             }
 
-            const auto key = parse_key(p);
+            auto key = parse_key(p, alloc);
+
+            if (**p == '\0') {
+                break;
+            }
 
             (*p)++;
 
             if (!std::empty(key)) {
                 auto& obj = std::get<object_type>(value._value);
-                auto [it, success] = obj.emplace(key, null_type {});
+                // the key moves into the member, its buffer was counted by parse_key
+                auto [it, success] = obj.emplace(std::move(key), null_type {});
                 if (success) {
-                    parse_value(p, it->second);
+                    JSON5_STATS(detail::count_allocation(sizeof(typename object_type::value_type) + detail::estimated_node_overhead));
+                    parse_value(p, it->second, options, alloc);
+                } else {
+                    // the first occurrence of a key wins
+                    value_type duplicate;
+                    parse_value(p, duplicate, options, alloc);
                 }
             }
         }
     }
 
-    static auto parse_value(const char** p, value_type& value) -> void {
+    static auto parse_value(
+        const char** p, value_type& value, const parse_options& options = {}, const container_allocator_type& alloc = {}) -> void {
         skip_spaces_and_comments(p);
         const auto ch = **p;
 
         switch (ch) {
         case '{':
-            parse_object(p, value);
+            parse_object(p, value, options, alloc);
             break;
         case '[':
-            parse_array(p, value);
+            parse_array(p, value, options, alloc);
             break;
         case '"':
         case '\'':
-            parse_string(p, value);
+            parse_string(p, value, alloc);
             break;
         case 'n':
             parse_null(p, value);
@@ -521,19 +956,296 @@ public:
         }
     }
 
-    static auto parse(string_view_type str) -> basic_json_value {
+    /// advances past the next value like parse_value, without decoding strings or converting numbers
+    static auto skip_value(const char** p) -> void {
+        skip_spaces_and_comments(p);
+
+        switch (**p) {
+        case '{':
+        case '[':
+            skip_container(p);
+            break;
+        case '"':
+        case '\'':
+            skip_string(p);
+            break;
+        case 'n':
+            if (strncmp(*p, "null", 4) == 0) {
+                *p += 4;
+            }
+            break;
+        case 't':
+            if (strncmp(*p, "true", 4) == 0) {
+                *p += 4;
+            }
+            break;
+        case 'f':
+            if (strncmp(*p, "false", 5) == 0) {
+                *p += 5;
+            }
+            break;
+        default:
+            if (isdigit(**p) || (**p == '-') || (**p == '+') || (**p == '.') || (**p == 'I') || (**p == 'N')) {
+                while (**p && !isspace(static_cast<unsigned char>(**p)) && !strchr(",]}/", **p)) {
+                    (*p)++;
+                }
+            }
+        }
+    }
+
+    /// every string and container of the result is created with alloc
+    static auto parse(string_view_type str, const parse_options& options = {}, const container_allocator_type& alloc = {})
+        -> basic_json_value {
         if (str.empty()) {
             return value_type {};
         }
 
         const char* p = std::data(str);
 
+        JSON5_STATS(detail::current_stats() = parse_stats {});
+        JSON5_STATS(const auto start = std::chrono::steady_clock::now());
+
         value_type val;
-        parse_value(&p, val);
+        parse_value(&p, val, options, alloc);
+
+        JSON5_STATS({
+            auto& stats = detail::current_stats();
+            stats.bytes_scanned = static_cast<std::size_t>(p - std::data(str));
+            stats.structural_time = std::chrono::steady_clock::now() - start - stats.string_time - stats.number_time;
+            if (stats_callback()) {
+                stats_callback()(stats);
+            }
+        });
+
         return val;
     }
+
+private:
+    static auto copy_value(const json_value& v) -> json_value {
+        return std::visit(
+            [](const auto& alternative) -> json_value {
+                using T = std::decay_t<decltype(alternative)>;
+                if constexpr (std::is_same_v<T, null_type> || std::is_arithmetic_v<T>) {
+                    return alternative;
+                } else {
+                    return detail::copy_container(alternative);
+                }
+            },
+            v);
+    }
+
+    /// decodes the quoted string at *p, shared by string values and quoted keys
+    static auto read_string(const char** p, const container_allocator_type& alloc) -> string_type {
+        auto res = detail::construct_with<string_type>(alloc);
+        const auto quote = **p;
+        auto b = *p + 1;
+        auto e = b;
+        while (*e) {
+            if (*e == '\\' && *(e + 1) == quote) {
+                e += 2;
+                continue;
+            } else if (detail::is_escape(e)) {
+                res += *e;
+                e++;
+                continue;
+            } else if (*e == quote) {
+                break;
+            }
+            res += *e;
+            ++e;
+        }
+        *p = *e ? e + 1 : e;
+        return res;
+    }
+
+    /// same extent as parse_string, only an escaped quote is skipped as a pair
+    static auto skip_string(const char** p) {
+        const auto quote = **p;
+        auto e = *p + 1;
+        while (*e) {
+            if (*e == '\\' && *(e + 1) == quote) {
+                e += 2;
+                continue;
+            } else if (*e == quote) {
+                break;
+            }
+            ++e;
+        }
+        *p = *e ? e + 1 : e;
+    }
+
+    /// skips a whole object or array, jumping between brackets, quotes and comments
+    static auto skip_container(const char** p) {
+        std::size_t depth = 0;
+        auto e = *p;
+        while ((e = strpbrk(e, "{}[]\"'/")) != nullptr) {
+            switch (*e) {
+            case '{':
+            case '[':
+                depth++;
+                e++;
+                break;
+            case '}':
+            case ']':
+                e++;
+                if (--depth == 0) {
+                    *p = e;
+                    return;
+                }
+                break;
+            case '/':
+                if (*(e + 1) == '/' || *(e + 1) == '*') {
+                    *p = e;
+                    skip_spaces_and_comments(p);
+                    e = *p;
+                } else {
+                    e++;
+                }
+                break;
+            default:
+                *p = e;
+                skip_string(p);
+                e = *p;
+            }
+        }
+        *p += strlen(*p);
+    }
+
+    static auto equal_numbers(number_type x, number_type y) -> bool {
+        return x == y || (x != x && y != y);
+    }
+
+    static auto equal(const basic_json_value& a, const basic_json_value& b) -> bool {
+        if (&a == &b) {
+            return true;
+        }
+
+        if (a.is_array() && b.is_array()) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            if (auto x = std::get_if<int_array_type>(&a._value), y = std::get_if<int_array_type>(&b._value); x && y) {
+                return *x == *y;
+            } else if (auto u = std::get_if<number_array_type>(&a._value), v = std::get_if<number_array_type>(&b._value); u && v) {
+                return std::equal(u->begin(), u->end(), v->begin(), equal_numbers);
+            } else if (auto i = std::get_if<boolean_array_type>(&a._value), j = std::get_if<boolean_array_type>(&b._value); i && j) {
+                return *i == *j;
+            }
+            for (size_type idx = 0; idx < a.size(); idx++) {
+                const auto ea = a.find(idx);
+                const auto eb = b.find(idx);
+                if (ea && eb ? !equal(*ea, *eb) : !equal(ea ? *ea : a.packed_at(idx), eb ? *eb : b.packed_at(idx))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        if (a._value.index() != b._value.index()) {
+            return false;
+        }
+
+        if (auto x = std::get_if<boolean_type>(&a._value); x) {
+            return *x == std::get<boolean_type>(b._value);
+        } else if (auto s = std::get_if<string_type>(&a._value); s) {
+            return *s == std::get<string_type>(b._value);
+        } else if (auto n = std::get_if<number_type>(&a._value); n) {
+            return equal_numbers(*n, std::get<number_type>(b._value));
+        } else if (auto i = std::get_if<int_type>(&a._value); i) {
+            return *i == std::get<int_type>(b._value);
+        } else if (auto obj = std::get_if<object_type>(&a._value); obj) {
+            const auto& other = std::get<object_type>(b._value);
+            if (obj->size() != other.size()) {
+                return false;
+            }
+            for (const auto& [k, v] : *obj) {
+                auto it = other.find(k);
+                if (it == other.end() || !equal(v, it->second)) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /// packed and node arrays hash alike, elements are combined in order
+    template <typename Container, typename Hash> static auto hash_elements(const Container& c, Hash&& h) -> std::uint64_t {
+        std::uint64_t acc = 0;
+        for (const auto& v : c) {
+            acc = detail::hash_combine(acc, h(v));
+        }
+        return detail::hash_container(detail::hash_array, acc, c.size());
+    }
+
+    auto packed_at(size_type idx) const -> basic_json_value {
+        if (auto ints = std::get_if<int_array_type>(&_value); ints) {
+            return (*ints)[idx];
+        } else if (auto numbers = std::get_if<number_array_type>(&_value); numbers) {
+            return (*numbers)[idx];
+        } else if (auto booleans = std::get_if<boolean_array_type>(&_value); booleans) {
+            return static_cast<boolean_type>((*booleans)[idx]);
+        }
+
+        return basic_json_value { null_type {} };
+    }
+
+    template <typename Packed> static auto unpack_array(const Packed& packed) -> array_type {
+        auto arr = detail::construct_with<array_type>(packed.get_allocator());
+        arr.reserve(packed.size());
+        for (const auto v : packed) {
+            arr.emplace_back(static_cast<typename Packed::value_type>(v));
+        }
+        return arr;
+    }
+
+    template <typename Container, typename T> static auto push_element(Container& c, T&& v) {
+        JSON5_STATS(const auto capacity = c.capacity());
+        c.emplace_back(std::forward<T>(v));
+        JSON5_STATS(if (c.capacity() != capacity) { detail::count_allocation(c.capacity() * sizeof(typename Container::value_type)); });
+    }
+
+    /// appends to an array that is still empty or packed, the first element decides about packed storage
+    static auto append_element(value_type& value, value_type&& element) {
+        if (auto arr = std::get_if<array_type>(&value._value); arr && arr->empty()) {
+            // packed storage goes where the array was allocated
+            const auto alloc = arr->get_allocator();
+            if (element.is_number_integer()) {
+                value._value = detail::construct_with<int_array_type>(alloc);
+            } else if (element.is_number()) {
+                value._value = detail::construct_with<number_array_type>(alloc);
+            } else if (element.is_boolean()) {
+                value._value = detail::construct_with<boolean_array_type>(alloc);
+            }
+        }
+
+        if (auto ints = std::get_if<int_array_type>(&value._value); ints && element.is_number_integer()) {
+            push_element(*ints, std::get<int_type>(element._value));
+        } else if (auto numbers = std::get_if<number_array_type>(&value._value); numbers && element.is_number()) {
+            push_element(*numbers, std::get<number_type>(element._value));
+        } else if (auto booleans = std::get_if<boolean_array_type>(&value._value); booleans && element.is_boolean()) {
+            push_element(*booleans, std::get<boolean_type>(element._value));
+        } else {
+            value.unpack();
+            push_element(std::get<array_type>(value._value), std::move(element));
+        }
+    }
 }; // namespace json5
 
 using value = basic_json_value<std::variant, std::map, std::vector, std::string, std::string_view, std::int64_t, double>;
 
 } // namespace json5
+
+namespace std {
+template <template <typename... Args> typename VariantType, template <typename U, typename V, typename... Args> typename ObjectType,
+    template <typename U, typename... Args> typename DynArrayType, typename StringType, typename StringViewType, typename NumberIntType,
+    typename NumberFloatType>
+struct hash<json5::basic_json_value<VariantType, ObjectType, DynArrayType, StringType, StringViewType, NumberIntType, NumberFloatType>> {
+    using argument_type
+        = json5::basic_json_value<VariantType, ObjectType, DynArrayType, StringType, StringViewType, NumberIntType, NumberFloatType>;
+
+    auto operator()(const argument_type& v) const -> std::size_t {
+        return static_cast<std::size_t>(v.hash());
+    }
+};
+} // namespace std
@@ -0,0 +1,580 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+namespace json5 {
+
+enum class static_type : unsigned char { null, boolean, string, integer, number, object, array };
+
+///
+/// Node of a statically laid out document
+///
+/// Nodes are stored in pre-order, so the first child of a container directly
+/// follows it and next points past the end of the subtree. Keys and strings
+/// are views of the source literal, escape sequences are kept as written.
+///
+struct static_node {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    static_type type = static_type::null;
+    bool boolean = false;
+    std::int64_t integer = 0;
+    double number = 0.0;
+    std::string_view string;
+    std::string_view key;
+    std::size_t size = 0;
+    std::size_t next = npos;
+};
+
+namespace detail {
+    ///
+    /// Constexpr JSON5 parser, counts nodes when nodes is nullptr
+    ///
+    class static_parser {
+    public:
+        constexpr static_parser(std::string_view src, static_node* nodes)
+            : _src { src }
+            , _nodes { nodes } {
+        }
+
+        constexpr auto parse() -> std::size_t {
+            skip_spaces_and_comments();
+            parse_value({});
+            skip_spaces_and_comments();
+            if (_pos != _src.size()) {
+                error("unexpected characters after value");
+            }
+
+            return _count;
+        }
+
+    private:
+        static constexpr auto is_digit(char c) -> bool {
+            return c >= '0' && c <= '9';
+        }
+
+        static constexpr auto is_alpha(char c) -> bool {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        static constexpr auto is_space(char c) -> bool {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        static constexpr auto hex_digit(char c) -> int {
+            if (is_digit(c)) {
+                return c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+            }
+
+            return -1;
+        }
+
+        static constexpr void error(const char* message) {
+            if (message) {
+                throw std::invalid_argument(message);
+            }
+        }
+
+        constexpr auto peek(std::size_t offset = 0) const -> char {
+            return _pos + offset < _src.size() ? _src[_pos + offset] : '\0';
+        }
+
+        constexpr auto starts_with(std::string_view word) const -> bool {
+            return _src.substr(_pos, word.size()) == word;
+        }
+
+        constexpr auto add_node(static_type type, std::string_view key) -> std::size_t {
+            const auto idx = _count++;
+            if (_nodes) {
+                _nodes[idx] = static_node {};
+                _nodes[idx].type = type;
+                _nodes[idx].key = key;
+                _nodes[idx].next = idx + 1;
+            }
+
+            return idx;
+        }
+
+        constexpr void skip_spaces_and_comments() {
+            while (_pos < _src.size()) {
+                if (is_space(peek())) {
+                    _pos++;
+                } else if (peek() == '/' && peek(1) == '/') {
+                    while (_pos < _src.size() && peek() != '\n') {
+                        _pos++;
+                    }
+                } else if (peek() == '/' && peek(1) == '*') {
+                    _pos += 2;
+                    while (!(peek() == '*' && peek(1) == '/')) {
+                        if (_pos >= _src.size()) {
+                            error("unterminated comment");
+                        }
+                        _pos++;
+                    }
+                    _pos += 2;
+                } else {
+                    break;
+                }
+            }
+        }
+
+        constexpr auto parse_quoted() -> std::string_view {
+            const auto quote = peek();
+            const auto b = ++_pos;
+            while (peek() != quote) {
+                if (_pos >= _src.size()) {
+                    error("unterminated string");
+                }
+                _pos += peek() == '\\' ? 2 : 1;
+            }
+
+            return _src.substr(b, _pos++ - b);
+        }
+
+        constexpr auto parse_key() -> std::string_view {
+            if (peek() == '"' || peek() == '\'') {
+                return parse_quoted();
+            }
+
+            const auto b = _pos;
+            while (is_alpha(peek()) || is_digit(peek()) || peek() == '_' || peek() == '$') {
+                _pos++;
+            }
+
+            if (_pos == b || is_digit(_src[b])) {
+                error("invalid key");
+            }
+
+            return _src.substr(b, _pos - b);
+        }
+
+        template <char Close> constexpr void parse_container(std::size_t idx) {
+            _pos++;
+
+            std::size_t size = 0;
+            while (true) {
+                skip_spaces_and_comments();
+                if (peek() == Close) {
+                    _pos++;
+                    break;
+                }
+
+                if constexpr (Close == '}') {
+                    const auto key = parse_key();
+                    skip_spaces_and_comments();
+                    if (peek() != ':') {
+                        error("expected ':'");
+                    }
+                    _pos++;
+                    skip_spaces_and_comments();
+                    parse_value(key);
+                } else {
+                    parse_value({});
+                }
+                size++;
+
+                skip_spaces_and_comments();
+                if (peek() == ',') {
+                    _pos++;
+                } else if (peek() != Close) {
+                    error("expected ',' or closing bracket");
+                }
+            }
+
+            if (_nodes) {
+                _nodes[idx].size = size;
+                _nodes[idx].next = _count;
+            }
+        }
+
+        constexpr void parse_number(std::size_t idx) {
+            auto negative = false;
+            if (peek() == '-' || peek() == '+') {
+                negative = peek() == '-';
+                _pos++;
+            }
+
+            if (starts_with("Infinity") || starts_with("NaN")) {
+                const auto inf = peek() == 'I';
+                _pos += inf ? 8 : 3;
+                if (_nodes) {
+                    _nodes[idx].type = static_type::number;
+                    _nodes[idx].number = inf ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+                    _nodes[idx].number = negative ? -_nodes[idx].number : _nodes[idx].number;
+                }
+                return;
+            }
+
+            // integers must fit int64, -2^63 included
+            const auto max_integer = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + (negative ? 1 : 0);
+
+            if (peek() == '0' && (peek(1) == 'x' || peek(1) == 'X')) {
+                _pos += 2;
+                std::uint64_t n = 0;
+                if (hex_digit(peek()) < 0) {
+                    error("invalid hex number");
+                }
+                while (hex_digit(peek()) >= 0) {
+                    const auto digit = static_cast<std::uint64_t>(hex_digit(peek()));
+                    if (n > (max_integer - digit) / 16) {
+                        error("integer out of range");
+                    }
+                    n = n * 16 + digit;
+                    _pos++;
+                }
+                if (_nodes) {
+                    _nodes[idx].integer = to_integer(n, negative);
+                }
+                return;
+            }
+
+            // 19 significant digits are kept exactly, later digits only move the decimal exponent,
+            // which saturates long before it could overflow
+            constexpr auto exponent_limit = 100000000;
+            std::uint64_t mantissa = 0;
+            auto exponent = 0;
+            auto digits = 0;
+            auto is_float_point = false;
+
+            while (is_digit(peek())) {
+                if (mantissa < 1000000000000000000ull) {
+                    mantissa = mantissa * 10 + static_cast<std::uint64_t>(peek() - '0');
+                } else if (exponent < exponent_limit) {
+                    exponent++;
+                }
+                digits++;
+                _pos++;
+            }
+
+            if (peek() == '.') {
+                is_float_point = true;
+                _pos++;
+                while (is_digit(peek())) {
+                    if (mantissa < 1000000000000000000ull && exponent > -exponent_limit) {
+                        mantissa = mantissa * 10 + static_cast<std::uint64_t>(peek() - '0');
+                        exponent--;
+                    }
+                    digits++;
+                    _pos++;
+                }
+            }
+
+            if (digits == 0) {
+                error("invalid number");
+            }
+
+            if (peek() == 'e' || peek() == 'E') {
+                is_float_point = true;
+                _pos++;
+                auto negative_exponent = false;
+                if (peek() == '-' || peek() == '+') {
+                    negative_exponent = peek() == '-';
+                    _pos++;
+                }
+                if (!is_digit(peek())) {
+                    error("invalid exponent");
+                }
+                auto e = 0;
+                while (is_digit(peek())) {
+                    if (e < exponent_limit) {
+                        e = e * 10 + (peek() - '0');
+                    }
+                    _pos++;
+                }
+                exponent += negative_exponent ? -e : e;
+            }
+
+            if (!is_float_point && (exponent != 0 || mantissa > max_integer)) {
+                error("integer out of range");
+            }
+
+            if (!_nodes) {
+                return;
+            }
+
+            if (is_float_point) {
+                // below 1e-400 or above 1e400 every mantissa rounds to 0 or infinity
+                exponent = std::clamp(exponent, -400, 400);
+
+                // powers of ten up to 1e22 are exact, so a single rounding step is exact for short inputs
+                auto n = static_cast<double>(mantissa);
+                while (exponent != 0) {
+                    const auto step = exponent > 0 ? std::min(exponent, 22) : std::min(-exponent, 22);
+                    auto scale = 1.0;
+                    for (auto i = 0; i < step; i++) {
+                        scale *= 10.0;
+                    }
+                    if (exponent > 0 && n > std::numeric_limits<double>::max() / scale) {
+                        // overflowing arithmetic is not a constant expression, saturate instead
+                        n = std::numeric_limits<double>::infinity();
+                        break;
+                    }
+                    n = exponent > 0 ? n * scale : n / scale;
+                    exponent += exponent > 0 ? -step : step;
+                }
+                _nodes[idx].type = static_type::number;
+                _nodes[idx].number = negative ? -n : n;
+            } else {
+                _nodes[idx].integer = to_integer(mantissa, negative);
+            }
+        }
+
+        /// negates in unsigned arithmetic, so the most negative integer does not overflow
+        static constexpr auto to_integer(std::uint64_t n, bool negative) -> std::int64_t {
+            return negative && n > 0 ? -static_cast<std::int64_t>(n - 1) - 1 : static_cast<std::int64_t>(n);
+        }
+
+        constexpr void parse_value(std::string_view key) {
+            const auto ch = peek();
+            switch (ch) {
+            case '{':
+                parse_container<'}'>(add_node(static_type::object, key));
+                break;
+            case '[':
+                parse_container<']'>(add_node(static_type::array, key));
+                break;
+            case '"':
+            case '\'': {
+                const auto idx = add_node(static_type::string, key);
+                const auto str = parse_quoted();
+                if (_nodes) {
+                    _nodes[idx].string = str;
+                }
+                break;
+            }
+            default:
+                if (starts_with("null")) {
+                    add_node(static_type::null, key);
+                    _pos += 4;
+                } else if (starts_with("true") || starts_with("false")) {
+                    const auto idx = add_node(static_type::boolean, key);
+                    if (_nodes) {
+                        _nodes[idx].boolean = ch == 't';
+                    }
+                    _pos += ch == 't' ? 4 : 5;
+                } else if (is_digit(ch) || ch == '-' || ch == '+' || ch == '.' || ch == 'I' || ch == 'N') {
+                    parse_number(add_node(static_type::integer, key));
+                } else {
+                    error("unexpected character");
+                }
+            }
+        }
+
+        std::string_view _src;
+        static_node* _nodes = nullptr;
+        std::size_t _pos = 0;
+        std::size_t _count = 0;
+    };
+} // namespace detail
+
+///
+/// Read-only view of a static document node
+///
+class static_value {
+public:
+    constexpr static_value() = default;
+
+    constexpr static_value(const static_node* nodes, std::size_t idx)
+        : _nodes { nodes }
+        , _idx { idx } {
+    }
+
+    /// object inspection
+
+    constexpr bool is_null() const noexcept {
+        return !_nodes || node().type == static_type::null;
+    }
+
+    constexpr bool is_boolean() const noexcept {
+        return _nodes && node().type == static_type::boolean;
+    }
+
+    constexpr bool is_number_integer() const noexcept {
+        return _nodes && node().type == static_type::integer;
+    }
+
+    constexpr bool is_number() const noexcept {
+        return _nodes && node().type == static_type::number;
+    }
+
+    constexpr bool is_string() const noexcept {
+        return _nodes && node().type == static_type::string;
+    }
+
+    constexpr bool is_object() const noexcept {
+        return _nodes && node().type == static_type::object;
+    }
+
+    constexpr bool is_array() const noexcept {
+        return _nodes && node().type == static_type::array;
+    }
+
+    /// value access
+
+    template <typename T> constexpr auto get() const -> T {
+        if constexpr (std::is_same_v<T, bool>) {
+            check(static_type::boolean);
+            return node().boolean;
+        } else if constexpr (std::is_integral_v<T>) {
+            check(static_type::integer);
+            return static_cast<T>(node().integer);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            check(static_type::number);
+            return static_cast<T>(node().number);
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            check(static_type::string);
+            return node().string;
+        } else {
+            static_assert(detail::always_false_v<T>, "unsupported type!");
+        }
+    }
+
+    constexpr auto key() const -> std::string_view {
+        return _nodes ? node().key : std::string_view {};
+    }
+
+    /// element access
+
+    constexpr auto size() const -> std::size_t {
+        return is_object() || is_array() ? node().size : 0;
+    }
+
+    constexpr auto at(std::size_t idx) const -> static_value {
+        if (idx >= size()) {
+            return {};
+        }
+
+        auto child = _idx + 1;
+        for (; idx > 0; idx--) {
+            child = _nodes[child].next;
+        }
+
+        return { _nodes, child };
+    }
+
+    constexpr auto at(std::string_view key) const -> static_value {
+        if (!is_object()) {
+            return {};
+        }
+
+        auto child = _idx + 1;
+        for (std::size_t i = 0; i < node().size; i++, child = _nodes[child].next) {
+            if (_nodes[child].key == key) {
+                return { _nodes, child };
+            }
+        }
+
+        return {};
+    }
+
+    constexpr auto operator[](std::size_t idx) const {
+        return at(idx);
+    }
+
+    constexpr auto operator[](std::string_view key) const {
+        return at(key);
+    }
+
+    /// conversion to a runtime value
+    template <typename JsonValue = value> auto to_value() const -> JsonValue {
+        using string_type = typename JsonValue::string_type;
+
+        if (is_boolean()) {
+            return JsonValue { node().boolean };
+        } else if (is_number_integer()) {
+            return JsonValue { static_cast<typename JsonValue::int_type>(node().integer) };
+        } else if (is_number()) {
+            return JsonValue { static_cast<typename JsonValue::number_type>(node().number) };
+        } else if (is_string()) {
+            return JsonValue { string_type { node().string } };
+        } else if (is_object()) {
+            typename JsonValue::object_type obj;
+            for (std::size_t i = 0; i < size(); i++) {
+                const auto child = at(i);
+                obj.emplace(string_type { child.key() }, child.template to_value<JsonValue>());
+            }
+            return JsonValue { std::move(obj) };
+        } else if (is_array()) {
+            typename JsonValue::array_type arr;
+            arr.reserve(size());
+            for (std::size_t i = 0; i < size(); i++) {
+                arr.push_back(at(i).template to_value<JsonValue>());
+            }
+            return JsonValue { std::move(arr) };
+        }
+
+        return JsonValue {};
+    }
+
+private:
+    constexpr void check(static_type type) const {
+        if (!_nodes || node().type != type) {
+            throw std::invalid_argument("unexpected type");
+        }
+    }
+
+    constexpr auto node() const -> const static_node& {
+        return _nodes[_idx];
+    }
+
+    const static_node* _nodes = nullptr;
+    std::size_t _idx = 0;
+};
+
+///
+/// Statically laid out read-only document
+///
+template <std::size_t N> struct static_document {
+    std::array<static_node, N> nodes {};
+
+    constexpr auto root() const -> static_value {
+        return { nodes.data(), 0 };
+    }
+};
+
+/// number of nodes needed for the document, syntax errors fail compilation in constant evaluation
+constexpr auto static_node_count(std::string_view src) -> std::size_t {
+    return detail::static_parser { src, nullptr }.parse();
+}
+
+template <std::size_t N> constexpr auto parse_static(std::string_view src) -> static_document<N> {
+    static_document<N> doc;
+    detail::static_parser { src, doc.nodes.data() }.parse();
+    return doc;
+}
+
+} // namespace json5
+
+#define JSON5_LITERAL(str) ::json5::parse_static<::json5::static_node_count(str)>(str)
@@ -0,0 +1,218 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/patch.hpp>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace json5 {
+
+///
+/// Read-only merged view of a base document and any number of override layers
+///
+/// Layers are applied in order like JSON Merge Patches (RFC 7386): objects are
+/// merged member by member, anything else replaces what earlier layers set, and
+/// a null member removes it. The merged document is kept together with an
+/// index from JSON pointers to its nodes, so a lookup costs the same however
+/// many layers there are. Packed arrays are unpacked in the merged document so
+/// that each of their elements has a node as well. When a layer changes only
+/// the top level members whose value differs are merged and indexed again.
+///
+template <typename JsonValue> class basic_layered_document {
+public:
+    using value_type = JsonValue;
+    using object_type = typename value_type::object_type;
+    using array_type = typename value_type::array_type;
+    using size_type = std::size_t;
+
+    // ctor
+
+    basic_layered_document() {
+        rebuild();
+    }
+
+    // parentheses, a braced vector of values would become a single array layer
+    explicit basic_layered_document(std::vector<value_type> layers)
+        : _layers(std::move(layers)) {
+        rebuild();
+    }
+
+    basic_layered_document(const basic_layered_document&) = delete;
+    basic_layered_document& operator=(const basic_layered_document&) = delete;
+
+    auto layer_count() const noexcept -> size_type {
+        return std::size(_layers);
+    }
+
+    auto layer(size_type idx) const -> const value_type& {
+        return _layers.at(idx);
+    }
+
+    auto merged() const noexcept -> const value_type& {
+        return _merged;
+    }
+
+    /// node at a JSON pointer in the merged document
+    auto find(std::string_view pointer) const -> const value_type* {
+        if (auto it = _index.find(pointer); it != _index.end()) {
+            return it->second;
+        }
+
+        return nullptr;
+    }
+
+    /// replaces a layer, returns the number of top level members that were merged again
+    auto set_layer(size_type idx, value_type val) -> size_type {
+        auto& current = _layers.at(idx);
+        // a document without layers has no merged object to update yet
+        if (!all_objects() || !val.is_object() || !_merged.is_object()) {
+            current = std::move(val);
+            rebuild();
+            return std::size(_merged);
+        }
+
+        std::vector<std::string> changed;
+        const auto& before = std::get<object_type>(current._value);
+        const auto& after = std::get<object_type>(val._value);
+        for (const auto& [k, v] : before) {
+            const auto other = val.find(k);
+            if (!other || *other != v) {
+                changed.emplace_back(std::data(k), std::size(k));
+            }
+        }
+        for (const auto& [k, v] : after) {
+            if (!current.find(k)) {
+                changed.emplace_back(std::data(k), std::size(k));
+            }
+        }
+
+        current = std::move(val);
+        for (const auto& key : changed) {
+            rebuild_member(key);
+        }
+
+        return std::size(changed);
+    }
+
+    /// adds a layer on top of all others
+    auto push_layer(value_type val) -> void {
+        // an empty object changes nothing, so only the members of val are merged
+        _layers.push_back(value_type { object_type {} });
+        set_layer(std::size(_layers) - 1, std::move(val));
+    }
+
+private:
+    auto all_objects() const -> bool {
+        return !_layers.empty() && std::all_of(_layers.begin(), _layers.end(), [](const auto& l) { return l.is_object(); });
+    }
+
+    void rebuild() {
+        _merged = value_type {};
+        for (const auto& l : _layers) {
+            apply_merge_patch(_merged, l);
+        }
+
+        _index.clear();
+        std::string path;
+        index(path, _merged);
+    }
+
+    /// merges a single top level member of all layers and indexes it again
+    void rebuild_member(const std::string& key) {
+        const auto& k = key_of(key);
+
+        value_type member;
+        bool present = false;
+        for (const auto& l : _layers) {
+            if (const auto v = l.find(k); v) {
+                if (v->is_null()) {
+                    member = value_type {};
+                    present = false;
+                } else {
+                    apply_merge_patch(member, *v);
+                    present = true;
+                }
+            }
+        }
+
+        std::string path;
+        detail::append_pointer(path, key);
+        unindex(path);
+
+        auto& obj = std::get<object_type>(_merged._value);
+        if (!present) {
+            obj.erase(k);
+            return;
+        }
+
+        auto& slot = obj[k];
+        slot = std::move(member);
+        index(path, slot);
+    }
+
+    auto key_of(const std::string& key) const -> typename object_type::key_type {
+        return typename object_type::key_type { std::data(key), std::size(key) };
+    }
+
+    void index(std::string& path, value_type& val) {
+        _index.emplace(path, &val);
+
+        const auto size = std::size(path);
+        if (val.is_object()) {
+            for (auto& [k, v] : std::get<object_type>(val._value)) {
+                detail::append_pointer(path, { std::data(k), std::size(k) });
+                index(path, v);
+                path.resize(size);
+            }
+        } else if (val.is_array()) {
+            val.unpack();
+            auto& arr = std::get<array_type>(val._value);
+            for (size_type i = 0; i < std::size(arr); i++) {
+                detail::append_pointer(path, std::to_string(i));
+                index(path, arr[i]);
+                path.resize(size);
+            }
+        }
+    }
+
+    /// removes a node and all of its children from the index
+    void unindex(const std::string& path) {
+        _index.erase(path);
+        const auto first = _index.lower_bound(path + '/');
+        const auto last = _index.lower_bound(path + char('/' + 1));
+        _index.erase(first, last);
+    }
+
+    std::vector<value_type> _layers;
+    value_type _merged;
+    std::map<std::string, const value_type*, std::less<>> _index;
+};
+
+using layered_document = basic_layered_document<value>;
+
+} // namespace json5
@@ -0,0 +1,684 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+#include <json5/persistent.hpp>
+
+#include <limits>
+#include <optional>
+#include <unordered_map>
+
+namespace json5 {
+
+namespace detail {
+    /// element of an array of nodes or a packed array, scratch holds packed elements
+    template <typename JsonValue> auto element_at(const JsonValue& arr, std::size_t idx, JsonValue& scratch) -> const JsonValue* {
+        if (auto e = arr.find(idx); e) {
+            return e;
+        }
+
+        scratch = arr.at(idx);
+        return &scratch;
+    }
+
+    /// appends a JSON pointer reference token, escaping '~' and '/'
+    template <typename String> auto append_pointer(String& path, std::string_view token) {
+        path += '/';
+        for (const auto ch : token) {
+            if (ch == '~') {
+                path += "~0";
+            } else if (ch == '/') {
+                path += "~1";
+            } else {
+                path += ch;
+            }
+        }
+    }
+
+    /// collects patch operations under the current JSON pointer
+    template <typename JsonValue> class patch_writer {
+    public:
+        using value_type = JsonValue;
+        using string_type = typename value_type::string_type;
+        using object_type = typename value_type::object_type;
+        using array_type = typename value_type::array_type;
+        using size_type = std::size_t;
+
+        auto result() -> value_type {
+            return value_type { std::move(_ops) };
+        }
+
+    protected:
+        void append_index(size_type idx) {
+            append_pointer(_path, std::to_string(idx));
+        }
+
+        void add_op(const char* op, const value_type* val) {
+            object_type obj;
+            obj.emplace("op", value_type { string_type { op } });
+            obj.emplace("path", value_type { _path });
+            if (val) {
+                obj.emplace("value", *val);
+            }
+            _ops.emplace_back(std::move(obj));
+        }
+
+        string_type _path;
+        array_type _ops;
+    };
+
+    template <typename JsonValue> class patch_builder : public patch_writer<JsonValue> {
+        using base = patch_writer<JsonValue>;
+        using base::_path;
+        using base::add_op;
+        using base::append_index;
+
+    public:
+        using typename base::array_type;
+        using typename base::object_type;
+        using typename base::size_type;
+        using typename base::value_type;
+
+        void diff(const value_type& from, const value_type& to) {
+            if (&from == &to) {
+                return;
+            }
+
+            if (from.is_object() && to.is_object()) {
+                diff_objects(std::get<object_type>(from._value), std::get<object_type>(to._value));
+            } else if (from.is_array() && to.is_array()) {
+                diff_arrays(from, to);
+            } else if (from != to) {
+                add_op("replace", &to);
+            }
+        }
+
+    private:
+        void diff_objects(const object_type& from, const object_type& to) {
+            // both maps are sorted, a single merge pass finds all differences
+            auto f = from.begin();
+            auto t = to.begin();
+            while (f != from.end() || t != to.end()) {
+                const auto size = _path.size();
+                if (t == to.end() || (f != from.end() && f->first < t->first)) {
+                    append_pointer(_path, f->first);
+                    add_op("remove", nullptr);
+                    ++f;
+                } else if (f == from.end() || t->first < f->first) {
+                    append_pointer(_path, t->first);
+                    add_op("add", &t->second);
+                    ++t;
+                } else {
+                    append_pointer(_path, f->first);
+                    diff(f->second, t->second);
+                    ++f;
+                    ++t;
+                }
+                _path.resize(size);
+            }
+        }
+
+        void diff_arrays(const value_type& from, const value_type& to) {
+            if (from.is_packed_array() && same(from, to)) {
+                return;
+            }
+
+            value_type sf, st;
+            const auto n = from.size();
+            const auto m = to.size();
+
+            // common prefix and suffix
+            size_type prefix = 0;
+            while (prefix < n && prefix < m && same(*element_at(from, prefix, sf), *element_at(to, prefix, st))) {
+                prefix++;
+            }
+            size_type suffix = 0;
+            while (suffix < n - prefix && suffix < m - prefix
+                && same(*element_at(from, n - 1 - suffix, sf), *element_at(to, m - 1 - suffix, st))) {
+                suffix++;
+            }
+
+            const auto size = _path.size();
+            const auto common = std::min(n, m) - prefix - suffix;
+            for (size_type i = prefix; i < prefix + common; i++) {
+                append_index(i);
+                diff(*element_at(from, i, sf), *element_at(to, i, st));
+                _path.resize(size);
+            }
+
+            // removals from the back keep the preceding indices valid
+            for (auto i = n - suffix; i > prefix + common; i--) {
+                append_index(i - 1);
+                add_op("remove", nullptr);
+                _path.resize(size);
+            }
+            for (auto i = prefix + common; i < m - suffix; i++) {
+                append_index(i);
+                add_op("add", element_at(to, i, st));
+                _path.resize(size);
+            }
+        }
+
+        /// unequal hashes settle most comparisons without descending into the subtrees
+        auto same(const value_type& a, const value_type& b) -> bool {
+            return hash_of(a) == hash_of(b) && a == b;
+        }
+
+        /// structural hash, memoized per container so that every subtree is hashed only once
+        auto hash_of(const value_type& v) -> std::uint64_t {
+            if (!v.is_object() && !v.is_array()) {
+                return v.hash();
+            }
+            if (const auto it = _hashes.find(&v); it != _hashes.end()) {
+                return it->second;
+            }
+
+            std::uint64_t h = 0;
+            if (auto obj = std::get_if<object_type>(&v._value); obj) {
+                std::uint64_t acc = 0;
+                for (const auto& [k, child] : *obj) {
+                    acc += detail::hash_member(detail::hash_string_value(k), hash_of(child));
+                }
+                h = detail::hash_container(detail::hash_object, acc, obj->size());
+            } else if (auto arr = std::get_if<array_type>(&v._value); arr) {
+                std::uint64_t acc = 0;
+                for (const auto& child : *arr) {
+                    acc = detail::hash_combine(acc, hash_of(child));
+                }
+                h = detail::hash_container(detail::hash_array, acc, arr->size());
+            } else {
+                h = v.hash();
+            }
+
+            _hashes.emplace(&v, h);
+            return h;
+        }
+
+        std::unordered_map<const value_type*, std::uint64_t> _hashes;
+    };
+
+    template <typename JsonValue> class persistent_patch_builder : public patch_writer<JsonValue> {
+        using base = patch_writer<JsonValue>;
+        using base::_path;
+        using base::add_op;
+        using base::append_index;
+
+    public:
+        using typename base::size_type;
+        using typename base::string_type;
+        using typename base::value_type;
+        using source_type = basic_persistent_value<JsonValue>;
+
+        void diff(const source_type& from, const source_type& to) {
+            // shared nodes and cached hashes settle equal subtrees without descending
+            if (from == to) {
+                return;
+            }
+
+            if (from.is_object() && to.is_object()) {
+                diff_objects(from, to);
+            } else if (from.is_array() && to.is_array()) {
+                diff_arrays(from, to);
+            } else {
+                add(&to, "replace");
+            }
+        }
+
+    private:
+        using member = std::pair<const string_type*, const source_type*>;
+
+        void diff_objects(const source_type& from, const source_type& to) {
+            std::vector<member> fm, tm;
+            fm.reserve(from.size());
+            tm.reserve(to.size());
+            from.for_each_member([&fm](const string_type& k, const source_type& v) { fm.emplace_back(&k, &v); });
+            to.for_each_member([&tm](const string_type& k, const source_type& v) { tm.emplace_back(&k, &v); });
+
+            auto f = fm.begin();
+            auto t = tm.begin();
+            while (f != fm.end() || t != tm.end()) {
+                const auto size = _path.size();
+                if (t == tm.end() || (f != fm.end() && *f->first < *t->first)) {
+                    append_pointer(_path, *f->first);
+                    add_op("remove", nullptr);
+                    ++f;
+                } else if (f == fm.end() || *t->first < *f->first) {
+                    append_pointer(_path, *t->first);
+                    add(t->second, "add");
+                    ++t;
+                } else {
+                    append_pointer(_path, *f->first);
+                    diff(*f->second, *t->second);
+                    ++f;
+                    ++t;
+                }
+                _path.resize(size);
+            }
+        }
+
+        void diff_arrays(const source_type& from, const source_type& to) {
+            std::vector<const source_type*> fe, te;
+            fe.reserve(from.size());
+            te.reserve(to.size());
+            from.for_each_element([&fe](const source_type& v) { fe.push_back(&v); });
+            to.for_each_element([&te](const source_type& v) { te.push_back(&v); });
+
+            const auto n = fe.size();
+            const auto m = te.size();
+
+            size_type prefix = 0;
+            while (prefix < n && prefix < m && *fe[prefix] == *te[prefix]) {
+                prefix++;
+            }
+            size_type suffix = 0;
+            while (suffix < n - prefix && suffix < m - prefix && *fe[n - 1 - suffix] == *te[m - 1 - suffix]) {
+                suffix++;
+            }
+
+            const auto size = _path.size();
+            const auto common = std::min(n, m) - prefix - suffix;
+            for (size_type i = prefix; i < prefix + common; i++) {
+                append_index(i);
+                diff(*fe[i], *te[i]);
+                _path.resize(size);
+            }
+
+            for (auto i = n - suffix; i > prefix + common; i--) {
+                append_index(i - 1);
+                add_op("remove", nullptr);
+                _path.resize(size);
+            }
+            for (auto i = prefix + common; i < m - suffix; i++) {
+                append_index(i);
+                add(te[i], "add");
+                _path.resize(size);
+            }
+        }
+
+        void add(const source_type* val, const char* op) {
+            const auto converted = val->to_value();
+            add_op(op, &converted);
+        }
+    };
+
+    template <typename JsonValue> auto merge_diff(const JsonValue& from, const JsonValue& to, JsonValue& patch) -> bool {
+        using object_type = typename JsonValue::object_type;
+
+        if (&from == &to) {
+            return false;
+        }
+
+        if (!from.is_object() || !to.is_object()) {
+            if (from == to) {
+                return false;
+            }
+            patch = to;
+            return true;
+        }
+
+        const auto& fo = std::get<object_type>(from._value);
+        const auto& to_obj = std::get<object_type>(to._value);
+        object_type result;
+
+        auto f = fo.begin();
+        auto t = to_obj.begin();
+        while (f != fo.end() || t != to_obj.end()) {
+            if (t == to_obj.end() || (f != fo.end() && f->first < t->first)) {
+                result.emplace_hint(result.end(), f->first, JsonValue {});
+                ++f;
+            } else if (f == fo.end() || t->first < f->first) {
+                result.emplace_hint(result.end(), t->first, t->second);
+                ++t;
+            } else {
+                JsonValue child;
+                if (merge_diff(f->second, t->second, child)) {
+                    result.emplace_hint(result.end(), t->first, std::move(child));
+                }
+                ++f;
+                ++t;
+            }
+        }
+
+        if (result.empty()) {
+            return false;
+        }
+
+        patch = JsonValue { std::move(result) };
+        return true;
+    }
+
+    /// splits a JSON pointer into unescaped reference tokens
+    template <typename String> auto split_pointer(std::string_view pointer, std::vector<String>& tokens) -> bool {
+        tokens.clear();
+        if (pointer.empty()) {
+            return true;
+        }
+        if (pointer.front() != '/') {
+            return false;
+        }
+
+        for (size_t i = 0; i < pointer.size(); i++) {
+            if (pointer[i] == '/') {
+                tokens.emplace_back();
+            } else if (pointer[i] == '~') {
+                if (i + 1 == pointer.size() || (pointer[i + 1] != '0' && pointer[i + 1] != '1')) {
+                    return false;
+                }
+                tokens.back() += pointer[++i] == '0' ? '~' : '/';
+            } else {
+                tokens.back() += pointer[i];
+            }
+        }
+
+        return true;
+    }
+
+    inline auto parse_index(std::string_view token, std::size_t size, bool allow_end) -> std::optional<std::size_t> {
+        if (allow_end && token == "-") {
+            return size;
+        }
+        if (token.empty() || (token.size() > 1 && token.front() == '0')) {
+            return std::nullopt;
+        }
+
+        std::size_t idx = 0;
+        for (const auto ch : token) {
+            if (ch < '0' || ch > '9') {
+                return std::nullopt;
+            }
+            const auto digit = static_cast<std::size_t>(ch - '0');
+            if (idx > (std::numeric_limits<std::size_t>::max() - digit) / 10) {
+                return std::nullopt;
+            }
+            idx = idx * 10 + digit;
+        }
+
+        if (idx > size || (!allow_end && idx == size)) {
+            return std::nullopt;
+        }
+
+        return idx;
+    }
+
+    template <typename JsonValue> class patch_applier {
+    public:
+        using value_type = JsonValue;
+        using string_type = typename value_type::string_type;
+        using object_type = typename value_type::object_type;
+        using array_type = typename value_type::array_type;
+
+        explicit patch_applier(value_type& doc)
+            : _doc { doc } {
+        }
+
+        auto apply(const value_type& op) -> bool {
+            const auto name = member(op, "op");
+            const auto path = member(op, "path");
+            if (!name || !path || !name->is_string() || !path->is_string()) {
+                return false;
+            }
+
+            const auto& kind = std::get<string_type>(name->_value);
+            const auto& target = std::get<string_type>(path->_value);
+
+            if (kind == "add" || kind == "replace" || kind == "test") {
+                const auto val = member(op, "value");
+                if (!val) {
+                    return false;
+                }
+                if (kind == "test") {
+                    const auto current = resolve(target);
+                    return current && *current == *val;
+                }
+                return kind == "add" ? add(target, *val) : (remove(target, nullptr) && add(target, *val));
+            } else if (kind == "remove") {
+                return remove(target, nullptr);
+            } else if (kind == "move" || kind == "copy") {
+                const auto from = member(op, "from");
+                if (!from || !from->is_string()) {
+                    return false;
+                }
+                const auto& source = std::get<string_type>(from->_value);
+                if (kind == "copy") {
+                    const auto current = resolve(source);
+                    return current && add(target, value_type { *current });
+                }
+                if (target.size() > source.size() && target.compare(0, source.size(), source) == 0 && target[source.size()] == '/') {
+                    // a value cannot be moved into one of its own children
+                    return false;
+                }
+                value_type moved;
+                return remove(source, &moved) && add(target, std::move(moved));
+            }
+
+            return false;
+        }
+
+    private:
+        static auto member(const value_type& op, const char* key) -> const value_type* {
+            return op.find(key);
+        }
+
+        auto resolve(std::string_view pointer) -> value_type* {
+            if (!split_pointer(pointer, _tokens)) {
+                return nullptr;
+            }
+            return walk(_tokens.size());
+        }
+
+        /// follows the first count tokens
+        auto walk(std::size_t count) -> value_type* {
+            auto* current = &_doc;
+            for (std::size_t i = 0; i < count; i++) {
+                if (current->is_object()) {
+                    auto& obj = std::get<object_type>(current->_value);
+                    auto it = obj.find(_tokens[i]);
+                    if (it == obj.end()) {
+                        return nullptr;
+                    }
+                    current = &it->second;
+                } else if (current->is_array()) {
+                    const auto idx = parse_index(_tokens[i], current->size(), false);
+                    if (!idx) {
+                        return nullptr;
+                    }
+                    current->unpack();
+                    current = &std::get<array_type>(current->_value)[*idx];
+                } else {
+                    return nullptr;
+                }
+            }
+            return current;
+        }
+
+        auto add(std::string_view pointer, value_type val) -> bool {
+            if (!split_pointer(pointer, _tokens)) {
+                return false;
+            }
+            if (_tokens.empty()) {
+                _doc = std::move(val);
+                return true;
+            }
+
+            auto* parent = walk(_tokens.size() - 1);
+            if (!parent) {
+                return false;
+            }
+
+            if (parent->is_object()) {
+                std::get<object_type>(parent->_value).insert_or_assign(_tokens.back(), std::move(val));
+                return true;
+            } else if (parent->is_array()) {
+                const auto idx = parse_index(_tokens.back(), parent->size(), true);
+                if (!idx) {
+                    return false;
+                }
+                parent->unpack();
+                auto& arr = std::get<array_type>(parent->_value);
+                arr.insert(arr.begin() + static_cast<std::ptrdiff_t>(*idx), std::move(val));
+                return true;
+            }
+
+            return false;
+        }
+
+        auto remove(std::string_view pointer, value_type* removed) -> bool {
+            if (!split_pointer(pointer, _tokens)) {
+                return false;
+            }
+            if (_tokens.empty()) {
+                if (removed) {
+                    *removed = std::move(_doc);
+                }
+                _doc = value_type {};
+                return true;
+            }
+
+            auto* parent = walk(_tokens.size() - 1);
+            if (!parent) {
+                return false;
+            }
+
+            if (parent->is_object()) {
+                auto& obj = std::get<object_type>(parent->_value);
+                auto it = obj.find(_tokens.back());
+                if (it == obj.end()) {
+                    return false;
+                }
+                if (removed) {
+                    *removed = std::move(it->second);
+                }
+                obj.erase(it);
+                return true;
+            } else if (parent->is_array()) {
+                const auto idx = parse_index(_tokens.back(), parent->size(), false);
+                if (!idx) {
+                    return false;
+                }
+                parent->unpack();
+                auto& arr = std::get<array_type>(parent->_value);
+                if (removed) {
+                    *removed = std::move(arr[*idx]);
+                }
+                arr.erase(arr.begin() + static_cast<std::ptrdiff_t>(*idx));
+                return true;
+            }
+
+            return false;
+        }
+
+        value_type& _doc;
+        std::vector<string_type> _tokens;
+    };
+} // namespace detail
+
+///
+/// JSON Patch (RFC 6902) turning from into to
+///
+/// Objects are compared in a single pass over both sorted maps, arrays are
+/// trimmed to the part between their common prefix and suffix. Subtrees that
+/// are the very same node are skipped without being visited, subtree hashes
+/// are computed once and rule out most unequal elements without descending.
+///
+template <typename JsonValue> auto diff(const JsonValue& from, const JsonValue& to) -> JsonValue {
+    detail::patch_builder<JsonValue> builder;
+    builder.diff(from, to);
+    return builder.result();
+}
+
+///
+/// JSON Patch (RFC 6902) between two persistent snapshots
+///
+/// Subtrees shared by both snapshots are skipped without being visited and
+/// cached node hashes rule out unequal subtrees without descending, so diffing
+/// a snapshot against a recent modification of it only walks the modified paths.
+///
+template <typename JsonValue>
+auto diff(const basic_persistent_value<JsonValue>& from, const basic_persistent_value<JsonValue>& to) -> JsonValue {
+    detail::persistent_patch_builder<JsonValue> builder;
+    builder.diff(from, to);
+    return builder.result();
+}
+
+///
+/// JSON Merge Patch (RFC 7386) turning from into to
+///
+/// Merge patches cannot express members that are set to null, those are removed.
+///
+template <typename JsonValue> auto merge_diff(const JsonValue& from, const JsonValue& to) -> JsonValue {
+    if (!from.is_object() || !to.is_object()) {
+        // an empty patch would turn any other value into an object
+        return to;
+    }
+
+    JsonValue patch;
+    if (!detail::merge_diff(from, to, patch)) {
+        return JsonValue { typename JsonValue::object_type {} };
+    }
+
+    return patch;
+}
+
+/// applies a JSON Patch, returns nullopt if any operation fails
+template <typename JsonValue> auto apply_patch(JsonValue doc, const JsonValue& patch) -> std::optional<JsonValue> {
+    if (!patch.is_array()) {
+        return std::nullopt;
+    }
+
+    detail::patch_applier<JsonValue> applier { doc };
+    for (std::size_t i = 0; i < patch.size(); i++) {
+        const auto op = patch.find(i);
+        if (!op || !applier.apply(*op)) {
+            return std::nullopt;
+        }
+    }
+
+    return doc;
+}
+
+/// applies a JSON Merge Patch in place
+template <typename JsonValue> void apply_merge_patch(JsonValue& target, const JsonValue& patch) {
+    using object_type = typename JsonValue::object_type;
+
+    if (!patch.is_object()) {
+        target = patch;
+        return;
+    }
+
+    if (!target.is_object()) {
+        target = object_type {};
+    }
+
+    auto& obj = std::get<object_type>(target._value);
+    for (const auto& [k, v] : std::get<object_type>(patch._value)) {
+        if (v.is_null()) {
+            obj.erase(k);
+        } else {
+            apply_merge_patch(obj[k], v);
+        }
+    }
+}
+
+} // namespace json5
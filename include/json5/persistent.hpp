@@ -0,0 +1,671 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace json5 {
+
+///
+/// Persistent (copy-on-write) JSON5 value
+///
+/// Nodes are immutable and reference counted, so copying a value is O(1) and
+/// snapshots may be read from any number of threads without locking. Every
+/// modification returns a new value that shares all untouched subtrees with
+/// the original. Object members and array elements live in a balanced tree
+/// with one tree node per child, so a modification copies only O(log width)
+/// tree nodes on each level of the modified path instead of the whole
+/// container. Each node caches its structural hash once computed, which makes
+/// comparing snapshots that share most of their subtrees cheap.
+///
+template <typename JsonValue> class basic_persistent_value {
+    struct entry;
+    using tree = std::shared_ptr<const entry>;
+
+public:
+    using json_value_type = JsonValue;
+    using value_type = basic_persistent_value;
+    using size_type = std::size_t;
+
+    using null_type = typename JsonValue::null_type;
+    using string_type = typename JsonValue::string_type;
+    using string_view_type = typename JsonValue::string_view_type;
+    using boolean_type = typename JsonValue::boolean_type;
+    using number_type = typename JsonValue::number_type;
+    using int_type = typename JsonValue::int_type;
+    using key_type = string_type;
+
+    /// single step of a path, either an object key or an array index
+    struct path_element {
+        path_element(const char* k)
+            : key { k } {
+        }
+
+        path_element(string_view_type k)
+            : key { k } {
+        }
+
+        path_element(string_type k)
+            : key { std::move(k) } {
+        }
+
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+        path_element(T i)
+            : index { static_cast<size_type>(i) }
+            , is_index { true } {
+        }
+
+        string_type key;
+        size_type index = 0;
+        bool is_index = false;
+    };
+
+    using path_type = std::initializer_list<path_element>;
+
+    // ctor
+
+    basic_persistent_value() = default;
+
+    basic_persistent_value(null_type) {
+    }
+
+    basic_persistent_value(boolean_type val)
+        : _node { make_node(val) } {
+    }
+
+    basic_persistent_value(const char* val)
+        : _node { make_node(string_type { val }) } {
+    }
+
+    basic_persistent_value(string_view_type val)
+        : _node { make_node(string_type { val }) } {
+    }
+
+    basic_persistent_value(string_type val)
+        : _node { make_node(std::move(val)) } {
+    }
+
+    basic_persistent_value(int_type val)
+        : _node { make_node(val) } {
+    }
+
+    basic_persistent_value(number_type val)
+        : _node { make_node(val) } {
+    }
+
+    /// conversion
+
+    static auto from_value(const json_value_type& val) -> basic_persistent_value {
+        if (val.is_boolean()) {
+            return std::get<boolean_type>(val._value);
+        } else if (val.is_number_integer()) {
+            return std::get<int_type>(val._value);
+        } else if (val.is_number()) {
+            return std::get<number_type>(val._value);
+        } else if (val.is_string()) {
+            return std::get<string_type>(val._value);
+        } else if (val.is_object()) {
+            std::vector<std::pair<string_type, basic_persistent_value>> members;
+            members.reserve(val.size());
+            for (const auto& [k, v] : std::get<typename json_value_type::object_type>(val._value)) {
+                members.emplace_back(k, from_value(v));
+            }
+            return basic_persistent_value { object_tree { build(members, 0, members.size()) } };
+        } else if (val.is_array()) {
+            std::vector<std::pair<string_type, basic_persistent_value>> elements;
+            elements.reserve(val.size());
+            for (size_type i = 0; i < val.size(); i++) {
+                const auto element = val.find(i);
+                elements.emplace_back(string_type {}, from_value(element ? *element : val.at(i)));
+            }
+            return basic_persistent_value { array_tree { build(elements, 0, elements.size()) } };
+        }
+
+        return {};
+    }
+
+    auto to_value() const -> json_value_type {
+        if (is_boolean()) {
+            return std::get<boolean_type>(data());
+        } else if (is_number_integer()) {
+            return std::get<int_type>(data());
+        } else if (is_number()) {
+            return std::get<number_type>(data());
+        } else if (is_string()) {
+            return std::get<string_type>(data());
+        } else if (is_object()) {
+            typename json_value_type::object_type obj;
+            for_each_entry(root(), [&obj](const entry& e) { obj.emplace_hint(obj.end(), e.key, e.value.to_value()); });
+            return json_value_type { std::move(obj) };
+        } else if (is_array()) {
+            typename json_value_type::array_type arr;
+            arr.reserve(size());
+            for_each_entry(root(), [&arr](const entry& e) { arr.push_back(e.value.to_value()); });
+            return json_value_type { std::move(arr) };
+        }
+
+        return {};
+    }
+
+    static auto parse(string_view_type str) -> basic_persistent_value {
+        return from_value(json_value_type::parse(str));
+    }
+
+    /// object inspection
+
+    bool is_null() const noexcept {
+        return !_node || std::holds_alternative<null_type>(_node->value);
+    }
+
+    bool is_boolean() const noexcept {
+        return _node && std::holds_alternative<boolean_type>(_node->value);
+    }
+
+    bool is_number_integer() const noexcept {
+        return _node && std::holds_alternative<int_type>(_node->value);
+    }
+
+    bool is_number() const noexcept {
+        return _node && std::holds_alternative<number_type>(_node->value);
+    }
+
+    bool is_string() const noexcept {
+        return _node && std::holds_alternative<string_type>(_node->value);
+    }
+
+    bool is_object() const noexcept {
+        return _node && std::holds_alternative<object_tree>(_node->value);
+    }
+
+    bool is_array() const noexcept {
+        return _node && std::holds_alternative<array_tree>(_node->value);
+    }
+
+    /// true when both values refer to the very same node, i.e. the subtree is shared
+    bool shares_node_with(const basic_persistent_value& other) const noexcept {
+        return _node == other._node;
+    }
+
+    /// value access
+
+    template <typename T> auto get() const -> T {
+        if constexpr (std::is_same_v<T, boolean_type>) {
+            return static_cast<T>(std::get<boolean_type>(data()));
+        } else if constexpr (std::is_integral_v<T>) {
+            return static_cast<T>(std::get<int_type>(data()));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(std::get<number_type>(data()));
+        } else if constexpr (std::is_same_v<T, string_type>) {
+            return std::get<string_type>(data());
+        } else if constexpr (std::is_same_v<T, string_view_type>) {
+            return std::get<string_type>(data());
+        } else {
+            static_assert(detail::always_false_v<T>, "unsupported type!");
+        }
+    }
+
+    template <typename T> auto value_or(T&& default_value) const -> T {
+        if constexpr (std::is_same_v<T, boolean_type>) {
+            return is_boolean() ? get<T>() : std::move(default_value);
+        } else if constexpr (std::is_integral_v<T>) {
+            return is_number_integer() ? get<T>() : std::move(default_value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            return is_number() ? get<T>() : std::move(default_value);
+        } else if constexpr (std::is_same_v<T, string_type> || std::is_same_v<T, string_view_type>) {
+            return is_string() ? get<T>() : std::move(default_value);
+        }
+
+        return std::move(default_value);
+    }
+
+    /// element access
+
+    auto find(size_type idx) const -> const basic_persistent_value* {
+        if (const auto e = entry_at(root(), idx); e) {
+            return &e->value;
+        }
+
+        return nullptr;
+    }
+
+    auto find(const key_type& key) const -> const basic_persistent_value* {
+        if (is_object()) {
+            if (const auto e = entry_of(root(), key); e) {
+                return &e->value;
+            }
+        }
+
+        return nullptr;
+    }
+
+    auto at(size_type idx) const -> basic_persistent_value {
+        if (auto v = find(idx); v) {
+            return *v;
+        }
+
+        return {};
+    }
+
+    auto at(const key_type& key) const -> basic_persistent_value {
+        if (is_object()) {
+            if (auto v = find(key); v) {
+                return *v;
+            }
+
+            throw std::out_of_range { "key not found" };
+        }
+
+        return {};
+    }
+
+    auto operator[](size_type idx) const {
+        return at(idx);
+    }
+
+    auto operator[](const key_type& key) const {
+        return at(key);
+    }
+
+    size_type size() const {
+        return size_of(root());
+    }
+
+    /// calls f(key, value) for each object member in key order
+    template <typename F> void for_each_member(F&& f) const {
+        if (is_object()) {
+            for_each_entry(root(), [&f](const entry& e) { f(e.key, e.value); });
+        }
+    }
+
+    /// calls f(value) for each array element in order
+    template <typename F> void for_each_element(F&& f) const {
+        if (is_array()) {
+            for_each_entry(root(), [&f](const entry& e) { f(e.value); });
+        }
+    }
+
+    /// comparison
+
+    /// same hash as the equal JsonValue, computed once per node
+    auto hash() const -> std::uint64_t {
+        if (!_node) {
+            return detail::hash_mix(detail::hash_null);
+        }
+
+        // 0 marks a hash that is not known yet, racing threads compute the same value
+        if (const auto cached = _node->hash.load(std::memory_order_relaxed); cached != 0) {
+            return cached;
+        }
+
+        const auto h = compute_hash();
+        _node->hash.store(h, std::memory_order_relaxed);
+        return h;
+    }
+
+    friend bool operator==(const basic_persistent_value& a, const basic_persistent_value& b) {
+        return equal(a, b);
+    }
+
+    friend bool operator!=(const basic_persistent_value& a, const basic_persistent_value& b) {
+        return !equal(a, b);
+    }
+
+    /// modification, every function returns a new value and leaves this one untouched
+
+    auto set(const key_type& key, basic_persistent_value val) const -> basic_persistent_value {
+        return basic_persistent_value { object_tree { assign(is_object() ? root() : tree {}, key, std::move(val)) } };
+    }
+
+    auto set(size_type idx, basic_persistent_value val) const -> basic_persistent_value {
+        const auto elements = is_array() ? root() : tree {};
+        if (idx == size_of(elements)) {
+            return basic_persistent_value { array_tree { insert_at(elements, idx, std::move(val)) } };
+        } else if (idx > size_of(elements)) {
+            throw std::out_of_range { "index out of range" };
+        }
+
+        return basic_persistent_value { array_tree { assign_at(elements, idx, std::move(val)) } };
+    }
+
+    auto set_in(path_type path, basic_persistent_value val) const -> basic_persistent_value {
+        return set_in(path.begin(), path.end(), std::move(val));
+    }
+
+    auto erase(const key_type& key) const -> basic_persistent_value {
+        if (!find(key)) {
+            return *this;
+        }
+
+        return basic_persistent_value { object_tree { erase(root(), key) } };
+    }
+
+    auto push_back(basic_persistent_value val) const -> basic_persistent_value {
+        return set(size(), std::move(val));
+    }
+
+private:
+    struct object_tree {
+        tree root;
+    };
+
+    struct array_tree {
+        tree root;
+    };
+
+    using node_value = std::variant<null_type, boolean_type, string_type, number_type, int_type, object_tree, array_tree>;
+
+    struct node {
+        explicit node(node_value v)
+            : value { std::move(v) } {
+        }
+
+        node_value value;
+        mutable std::atomic<std::uint64_t> hash { 0 };
+    };
+
+    explicit basic_persistent_value(object_tree val)
+        : _node { make_node(std::move(val)) } {
+    }
+
+    explicit basic_persistent_value(array_tree val)
+        : _node { make_node(std::move(val)) } {
+    }
+
+    template <typename T> static auto make_node(T&& val) -> std::shared_ptr<const node> {
+        return std::make_shared<const node>(node_value { std::forward<T>(val) });
+    }
+
+    auto compute_hash() const -> std::uint64_t {
+        if (is_boolean()) {
+            return detail::hash_scalar(static_cast<bool>(std::get<boolean_type>(data())));
+        } else if (is_number_integer()) {
+            return detail::hash_scalar(static_cast<std::int64_t>(std::get<int_type>(data())));
+        } else if (is_number()) {
+            return detail::hash_scalar(static_cast<double>(std::get<number_type>(data())));
+        } else if (is_string()) {
+            return detail::hash_string_value(std::get<string_type>(data()));
+        } else if (is_object()) {
+            std::uint64_t acc = 0;
+            for_each_entry(root(), [&acc](const entry& e) {
+                acc += detail::hash_member(detail::hash_string_value(e.key), e.value.hash());
+            });
+            return detail::hash_container(detail::hash_object, acc, size());
+        } else if (is_array()) {
+            std::uint64_t acc = 0;
+            for_each_entry(root(), [&acc](const entry& e) { acc = detail::hash_combine(acc, e.value.hash()); });
+            return detail::hash_container(detail::hash_array, acc, size());
+        }
+
+        return detail::hash_mix(detail::hash_null);
+    }
+
+    static auto equal(const basic_persistent_value& a, const basic_persistent_value& b) -> bool {
+        if (a._node == b._node) {
+            return true;
+        }
+
+        if (a.data().index() != b.data().index() || a.hash() != b.hash()) {
+            return false;
+        }
+
+        if (a.is_number()) {
+            const auto x = std::get<number_type>(a.data());
+            const auto y = std::get<number_type>(b.data());
+            return x == y || (x != x && y != y);
+        } else if (a.is_object() || a.is_array()) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+
+            std::vector<const entry*> x, y;
+            x.reserve(a.size());
+            y.reserve(b.size());
+            for_each_entry(a.root(), [&x](const entry& e) { x.push_back(&e); });
+            for_each_entry(b.root(), [&y](const entry& e) { y.push_back(&e); });
+            for (size_type i = 0; i < x.size(); i++) {
+                if (x[i]->key != y[i]->key || !equal(x[i]->value, y[i]->value)) {
+                    return false;
+                }
+            }
+            return true;
+        } else if (a.is_boolean()) {
+            return std::get<boolean_type>(a.data()) == std::get<boolean_type>(b.data());
+        } else if (a.is_number_integer()) {
+            return std::get<int_type>(a.data()) == std::get<int_type>(b.data());
+        } else if (a.is_string()) {
+            return std::get<string_type>(a.data()) == std::get<string_type>(b.data());
+        }
+
+        return true;
+    }
+
+    auto data() const -> const node_value& {
+        static const node_value null_value {};
+        return _node ? _node->value : null_value;
+    }
+
+    auto root() const -> const tree& {
+        static const tree empty {};
+        if (is_object()) {
+            return std::get<object_tree>(data()).root;
+        } else if (is_array()) {
+            return std::get<array_tree>(data()).root;
+        }
+
+        return empty;
+    }
+
+    auto set_in(const path_element* first, const path_element* last, basic_persistent_value val) const -> basic_persistent_value {
+        if (first == last) {
+            return val;
+        }
+
+        if (first->is_index) {
+            const auto child = find(first->index);
+            return set(first->index, (child ? *child : basic_persistent_value {}).set_in(first + 1, last, std::move(val)));
+        }
+
+        const auto child = find(first->key);
+        return set(first->key, (child ? *child : basic_persistent_value {}).set_in(first + 1, last, std::move(val)));
+    }
+
+    /// balanced (AVL) tree of children, ordered by key for objects and by position for arrays
+
+    static auto size_of(const tree& t) noexcept -> size_type {
+        return t ? t->size : 0;
+    }
+
+    static auto height_of(const tree& t) noexcept -> int {
+        return t ? t->height : 0;
+    }
+
+    static auto make_entry(string_type key, basic_persistent_value val, tree left, tree right) -> tree {
+        return std::make_shared<const entry>(std::move(key), std::move(val), std::move(left), std::move(right));
+    }
+
+    static auto balance(string_type key, basic_persistent_value val, tree left, tree right) -> tree {
+        if (height_of(left) > height_of(right) + 1) {
+            if (height_of(left->left) >= height_of(left->right)) {
+                return make_entry(
+                    left->key, left->value, left->left, make_entry(std::move(key), std::move(val), left->right, std::move(right)));
+            }
+
+            const auto& pivot = left->right;
+            return make_entry(pivot->key, pivot->value, make_entry(left->key, left->value, left->left, pivot->left),
+                make_entry(std::move(key), std::move(val), pivot->right, std::move(right)));
+        } else if (height_of(right) > height_of(left) + 1) {
+            if (height_of(right->right) >= height_of(right->left)) {
+                return make_entry(
+                    right->key, right->value, make_entry(std::move(key), std::move(val), std::move(left), right->left), right->right);
+            }
+
+            const auto& pivot = right->left;
+            return make_entry(pivot->key, pivot->value, make_entry(std::move(key), std::move(val), std::move(left), pivot->left),
+                make_entry(right->key, right->value, pivot->right, right->right));
+        }
+
+        return make_entry(std::move(key), std::move(val), std::move(left), std::move(right));
+    }
+
+    static auto build(const std::vector<std::pair<string_type, basic_persistent_value>>& items, size_type first, size_type last) -> tree {
+        if (first == last) {
+            return {};
+        }
+
+        const auto middle = first + (last - first) / 2;
+        return make_entry(items[middle].first, items[middle].second, build(items, first, middle), build(items, middle + 1, last));
+    }
+
+    template <typename F> static void for_each_entry(const tree& t, F&& f) {
+        if (t) {
+            for_each_entry(t->left, f);
+            f(*t);
+            for_each_entry(t->right, f);
+        }
+    }
+
+    static auto entry_at(const tree& t, size_type idx) -> const entry* {
+        auto e = t.get();
+        while (e) {
+            const auto left = size_of(e->left);
+            if (idx < left) {
+                e = e->left.get();
+            } else if (idx == left) {
+                return e;
+            } else {
+                idx -= left + 1;
+                e = e->right.get();
+            }
+        }
+
+        return nullptr;
+    }
+
+    static auto entry_of(const tree& t, const key_type& key) -> const entry* {
+        auto e = t.get();
+        while (e) {
+            if (key < e->key) {
+                e = e->left.get();
+            } else if (e->key < key) {
+                e = e->right.get();
+            } else {
+                return e;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static auto assign(const tree& t, const key_type& key, basic_persistent_value val) -> tree {
+        if (!t) {
+            return make_entry(key, std::move(val), {}, {});
+        } else if (key < t->key) {
+            return balance(t->key, t->value, assign(t->left, key, std::move(val)), t->right);
+        } else if (t->key < key) {
+            return balance(t->key, t->value, t->left, assign(t->right, key, std::move(val)));
+        }
+
+        return make_entry(t->key, std::move(val), t->left, t->right);
+    }
+
+    static auto erase_first(const tree& t) -> tree {
+        if (!t->left) {
+            return t->right;
+        }
+
+        return balance(t->key, t->value, erase_first(t->left), t->right);
+    }
+
+    static auto erase(const tree& t, const key_type& key) -> tree {
+        if (!t) {
+            return t;
+        } else if (key < t->key) {
+            return balance(t->key, t->value, erase(t->left, key), t->right);
+        } else if (t->key < key) {
+            return balance(t->key, t->value, t->left, erase(t->right, key));
+        } else if (!t->left) {
+            return t->right;
+        } else if (!t->right) {
+            return t->left;
+        }
+
+        const auto next = entry_at(t->right, 0);
+        return balance(next->key, next->value, t->left, erase_first(t->right));
+    }
+
+    static auto assign_at(const tree& t, size_type idx, basic_persistent_value val) -> tree {
+        const auto left = size_of(t->left);
+        if (idx < left) {
+            return make_entry(t->key, t->value, assign_at(t->left, idx, std::move(val)), t->right);
+        } else if (idx > left) {
+            return make_entry(t->key, t->value, t->left, assign_at(t->right, idx - left - 1, std::move(val)));
+        }
+
+        return make_entry(t->key, std::move(val), t->left, t->right);
+    }
+
+    static auto insert_at(const tree& t, size_type idx, basic_persistent_value val) -> tree {
+        if (!t) {
+            return make_entry({}, std::move(val), {}, {});
+        }
+
+        const auto left = size_of(t->left);
+        if (idx <= left) {
+            return balance(t->key, t->value, insert_at(t->left, idx, std::move(val)), t->right);
+        }
+
+        return balance(t->key, t->value, t->left, insert_at(t->right, idx - left - 1, std::move(val)));
+    }
+
+    std::shared_ptr<const node> _node;
+};
+
+template <typename JsonValue> struct basic_persistent_value<JsonValue>::entry {
+    entry(string_type k, basic_persistent_value v, tree l, tree r)
+        : key { std::move(k) }
+        , value { std::move(v) }
+        , left { std::move(l) }
+        , right { std::move(r) }
+        , size { size_of(left) + size_of(right) + 1 }
+        , height { std::max(height_of(left), height_of(right)) + 1 } {
+    }
+
+    string_type key;
+    basic_persistent_value value;
+    tree left;
+    tree right;
+    size_type size;
+    int height;
+};
+
+using persistent_value = basic_persistent_value<value>;
+
+} // namespace json5
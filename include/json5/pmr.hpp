@@ -0,0 +1,95 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <memory_resource>
+
+namespace json5::pmr {
+
+///
+/// JSON5 value whose strings, arrays and objects use polymorphic allocators
+///
+/// parse() places every container it creates in the given resource. Copies
+/// stay in the resource of the original, copy() moves a whole tree into
+/// another resource. Values built or modified without a resource, e.g. by
+/// diff() or apply_patch(), use the default resource for their new containers.
+///
+using value = basic_json_value<std::variant, std::pmr::map, std::pmr::vector, std::pmr::string, std::string_view, std::int64_t, double>;
+
+/// parses str with every container allocated from resource
+inline auto parse(std::string_view str, std::pmr::memory_resource* resource, const parse_options& options = {}) -> value {
+    return value::parse(str, options, value::container_allocator_type { resource });
+}
+
+/// deep copy of val with every container allocated from resource
+inline auto copy(const value& val, std::pmr::memory_resource* resource) -> value {
+    if (auto str = std::get_if<value::string_type>(&val._value); str) {
+        return value::string_type(*str, resource);
+    } else if (auto obj = std::get_if<value::object_type>(&val._value); obj) {
+        // keys are copied into the resource of the map
+        value::object_type res(resource);
+        for (const auto& [k, v] : *obj) {
+            res.emplace_hint(res.end(), k, copy(v, resource));
+        }
+        return value { std::move(res) };
+    } else if (auto arr = std::get_if<value::array_type>(&val._value); arr) {
+        value::array_type res(resource);
+        res.reserve(arr->size());
+        for (const auto& v : *arr) {
+            res.push_back(copy(v, resource));
+        }
+        return value { std::move(res) };
+    } else if (auto ints = std::get_if<value::int_array_type>(&val._value); ints) {
+        return value::int_array_type(*ints, resource);
+    } else if (auto numbers = std::get_if<value::number_array_type>(&val._value); numbers) {
+        return value::number_array_type(*numbers, resource);
+    } else if (auto booleans = std::get_if<value::boolean_array_type>(&val._value); booleans) {
+        return value::boolean_array_type(*booleans, resource);
+    }
+
+    return val;
+}
+
+/// resource holding the top level container of val, the default resource for scalars
+inline auto resource_of(const value& val) -> std::pmr::memory_resource* {
+    if (auto str = std::get_if<value::string_type>(&val._value); str) {
+        return str->get_allocator().resource();
+    } else if (auto obj = std::get_if<value::object_type>(&val._value); obj) {
+        return obj->get_allocator().resource();
+    } else if (auto arr = std::get_if<value::array_type>(&val._value); arr) {
+        return arr->get_allocator().resource();
+    } else if (auto ints = std::get_if<value::int_array_type>(&val._value); ints) {
+        return ints->get_allocator().resource();
+    } else if (auto numbers = std::get_if<value::number_array_type>(&val._value); numbers) {
+        return numbers->get_allocator().resource();
+    } else if (auto booleans = std::get_if<value::boolean_array_type>(&val._value); booleans) {
+        return booleans->get_allocator().resource();
+    }
+
+    return std::pmr::get_default_resource();
+}
+
+} // namespace json5::pmr
@@ -0,0 +1,205 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+namespace json5 {
+
+///
+/// Selection of paths to materialize while parsing
+///
+/// Each path is a list of object keys. The value at the end of a path is
+/// parsed completely, everything that is not on a path is skipped without
+/// decoding strings or converting numbers. A path continues through arrays:
+/// it is applied to every element, elements that are not objects or arrays
+/// become null so that indices stay the same.
+///
+template <typename JsonValue> class basic_projection {
+public:
+    using value_type = JsonValue;
+    using string_type = typename value_type::string_type;
+    using string_view_type = typename value_type::string_view_type;
+    using object_type = typename value_type::object_type;
+    using array_type = typename value_type::array_type;
+
+    // ctor
+
+    basic_projection() = default;
+
+    basic_projection(std::initializer_list<std::initializer_list<string_view_type>> paths) {
+        for (const auto& path : paths) {
+            add(path);
+        }
+    }
+
+    /// selects a top level member
+    auto add(string_view_type key) -> basic_projection& {
+        return add({ key });
+    }
+
+    auto add(std::initializer_list<string_view_type> path) -> basic_projection& {
+        auto* current = &_root;
+        for (const auto key : path) {
+            if (current->whole) {
+                // a shorter path already selects the whole subtree
+                return *this;
+            }
+            current = &current->child(key);
+        }
+        current->whole = true;
+        current->children.clear();
+        return *this;
+    }
+
+    auto parse(string_view_type str) const -> value_type {
+        value_type val;
+        if (str.empty()) {
+            return val;
+        }
+
+        const char* p = std::data(str);
+        parse_value(&p, val, _root);
+        return val;
+    }
+
+private:
+    /// std::vector is the standard container that may hold the still incomplete node
+    struct node {
+        string_type key;
+        std::vector<node> children; // sorted by key
+        bool whole = false;
+
+        auto find(string_view_type k) const -> const node* {
+            const auto it = lower_bound(children, k);
+            return it != children.end() && string_view_type { it->key } == k ? &*it : nullptr;
+        }
+
+        auto child(string_view_type k) -> node& {
+            const auto it = lower_bound(children, k);
+            if (it != children.end() && string_view_type { it->key } == k) {
+                return *it;
+            }
+            return *children.insert(it, node { string_type { k }, {}, false });
+        }
+
+        template <typename Nodes> static auto lower_bound(Nodes& nodes, string_view_type k) {
+            const auto less = [](const node& n, string_view_type v) { return string_view_type { n.key } < v; };
+            return std::lower_bound(nodes.begin(), nodes.end(), k, less);
+        }
+    };
+
+    static auto parse_value(const char** p, value_type& val, const node& selection) -> void {
+        if (selection.whole) {
+            value_type::parse_value(p, val);
+            return;
+        }
+
+        value_type::skip_spaces_and_comments(p);
+        if (**p == '{') {
+            parse_object(p, val, selection);
+        } else if (**p == '[') {
+            parse_array(p, val, selection);
+        } else {
+            value_type::skip_value(p);
+        }
+    }
+
+    static auto parse_object(const char** p, value_type& val, const node& selection) -> void {
+        val = object_type {};
+        auto& obj = std::get<object_type>(val._value);
+
+        (*p)++;
+
+        while (true) {
+            value_type::skip_spaces_and_comments(p);
+            if (**p == '}') {
+                (*p)++;
+                break;
+            }
+
+            const auto key = value_type::parse_key(p);
+
+            if (**p == '\0') {
+                break;
+            }
+
+            (*p)++;
+
+            if (!std::empty(key)) {
+                const auto child = selection.find(key);
+                if (child && obj.find(key) == obj.end()) {
+                    parse_value(p, obj[key], *child);
+                } else {
+                    value_type::skip_value(p);
+                }
+            }
+        }
+    }
+
+    static auto parse_array(const char** p, value_type& val, const node& selection) -> void {
+        val = array_type {};
+        auto& arr = std::get<array_type>(val._value);
+
+        (*p)++;
+
+        while (true) {
+            value_type::skip_spaces_and_comments(p);
+
+            if (**p == ',') {
+                (*p)++;
+                continue;
+            }
+
+            if (**p == ']') {
+                (*p)++;
+                break;
+            }
+
+            if (**p == '\0') {
+                break;
+            }
+
+            const auto b = *p;
+            value_type element;
+            parse_value(p, element, selection);
+            if (*p == b) {
+                // skip the unexpected character
+                (*p)++;
+                continue;
+            }
+            arr.push_back(std::move(element));
+        }
+    }
+
+    node _root;
+};
+
+using projection = basic_projection<value>;
+
+} // namespace json5
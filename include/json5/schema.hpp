@@ -0,0 +1,442 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+
+namespace json5 {
+
+namespace schema_type {
+    enum : unsigned {
+        null = 1u << 0,
+        boolean = 1u << 1,
+        string = 1u << 2,
+        integer = 1u << 3,
+        number = 1u << 4,
+        object = 1u << 5,
+        array = 1u << 6,
+        any = null | boolean | string | integer | number | object | array,
+    };
+} // namespace schema_type
+
+struct schema_error {
+    std::size_t offset = 0;
+    std::string path;
+    std::string message;
+};
+
+///
+/// Compiled schema, a JSON Schema subset validated while parsing
+///
+/// Supported keywords: type, enum, minimum, maximum, minLength, maxLength,
+/// minItems, maxItems, minProperties, maxProperties, properties, required,
+/// additionalProperties and items. Documents are rejected at the first
+/// violation, before the rest of the input is parsed.
+///
+template <typename JsonValue> class basic_schema {
+public:
+    using value_type = JsonValue;
+    using string_type = typename value_type::string_type;
+    using string_view_type = typename value_type::string_view_type;
+    using number_type = typename value_type::number_type;
+    using int_type = typename value_type::int_type;
+    using object_type = typename value_type::object_type;
+    using array_type = typename value_type::array_type;
+    using int_array_type = typename value_type::int_array_type;
+    using null_type = typename value_type::null_type;
+
+    unsigned types = schema_type::any;
+    std::optional<number_type> minimum;
+    std::optional<number_type> maximum;
+    std::optional<std::size_t> min_length;
+    std::optional<std::size_t> max_length;
+    std::optional<std::size_t> min_items;
+    std::optional<std::size_t> max_items;
+    std::optional<std::size_t> min_properties;
+    std::optional<std::size_t> max_properties;
+    std::vector<value_type> enumeration;
+    std::map<string_type, basic_schema> properties;
+    std::vector<string_type> required;
+    bool additional_properties = true;
+    std::shared_ptr<const basic_schema> items;
+
+    /// compilation
+
+    static auto compile(const value_type& doc) -> basic_schema {
+        basic_schema s;
+        if (!doc.is_object()) {
+            return s;
+        }
+
+        if (auto t = doc.find("type"); t) {
+            if (t->is_string()) {
+                s.types = type_bit(t->template get<string_type>());
+            } else if (t->is_array()) {
+                s.types = 0;
+                for (std::size_t i = 0; i < t->size(); i++) {
+                    s.types |= type_bit(t->at(i).value_or(string_type {}));
+                }
+            }
+        }
+
+        s.minimum = number_keyword(doc, "minimum");
+        s.maximum = number_keyword(doc, "maximum");
+
+        s.min_length = size_keyword(doc, "minLength");
+        s.max_length = size_keyword(doc, "maxLength");
+        s.min_items = size_keyword(doc, "minItems");
+        s.max_items = size_keyword(doc, "maxItems");
+        s.min_properties = size_keyword(doc, "minProperties");
+        s.max_properties = size_keyword(doc, "maxProperties");
+
+        if (auto e = doc.find("enum"); e && e->is_array()) {
+            for (std::size_t i = 0; i < e->size(); i++) {
+                s.enumeration.push_back(e->at(i));
+            }
+        }
+
+        if (auto props = doc.find("properties"); props && props->is_object()) {
+            for (const auto& [k, v] : std::get<object_type>(props->_value)) {
+                s.properties.emplace(k, compile(v));
+            }
+        }
+
+        if (auto req = doc.find("required"); req && req->is_array()) {
+            for (std::size_t i = 0; i < req->size(); i++) {
+                if (const auto key = req->at(i); key.is_string()) {
+                    s.required.push_back(key.template get<string_type>());
+                }
+            }
+        }
+
+        if (auto add = doc.find("additionalProperties"); add && add->is_boolean()) {
+            s.additional_properties = add->template get<bool>();
+        }
+
+        if (auto it = doc.find("items"); it && it->is_object()) {
+            s.items = std::make_shared<const basic_schema>(compile(*it));
+        }
+
+        return s;
+    }
+
+    /// parsing
+
+    auto parse(string_view_type str, schema_error* error = nullptr, const parse_options& options = {}) const -> std::optional<value_type> {
+        if (str.empty()) {
+            return {};
+        }
+
+        const char* p = std::data(str);
+        context ctx { p, error, options };
+
+        value_type val;
+        if (!parse_value(&p, this, val, ctx)) {
+            return {};
+        }
+
+        return val;
+    }
+
+private:
+    struct context {
+        const char* begin;
+        schema_error* error;
+        parse_options options;
+    };
+
+    static auto type_bit(string_view_type name) -> unsigned {
+        if (name == "null") {
+            return schema_type::null;
+        } else if (name == "boolean") {
+            return schema_type::boolean;
+        } else if (name == "string") {
+            return schema_type::string;
+        } else if (name == "integer") {
+            return schema_type::integer;
+        } else if (name == "number") {
+            return schema_type::number | schema_type::integer;
+        } else if (name == "object") {
+            return schema_type::object;
+        } else if (name == "array") {
+            return schema_type::array;
+        }
+
+        return 0;
+    }
+
+    static auto number_keyword(const value_type& doc, const char* key) -> std::optional<number_type> {
+        if (auto v = doc.find(key); v) {
+            if (v->is_number_integer()) {
+                return static_cast<number_type>(v->template get<int_type>());
+            } else if (v->is_number()) {
+                return v->template get<number_type>();
+            }
+        }
+
+        return {};
+    }
+
+    static auto size_keyword(const value_type& doc, const char* key) -> std::optional<std::size_t> {
+        if (auto n = number_keyword(doc, key); n) {
+            return *n > 0 ? static_cast<std::size_t>(*n) : 0;
+        }
+
+        return {};
+    }
+
+    static auto fail(context& ctx, const char* p, const char* message) -> bool {
+        if (ctx.error) {
+            ctx.error->offset = static_cast<std::size_t>(p - ctx.begin);
+            ctx.error->path.clear();
+            ctx.error->message = message;
+        }
+
+        return false;
+    }
+
+    static auto unwind(context& ctx, string_view_type segment) -> bool {
+        if (ctx.error) {
+            ctx.error->path.insert(0, segment);
+            ctx.error->path.insert(0, "/");
+        }
+
+        return false;
+    }
+
+    auto check_scalar(const value_type& val, const char* at, context& ctx) const -> bool {
+        unsigned type = schema_type::null;
+        if (val.is_boolean()) {
+            type = schema_type::boolean;
+        } else if (val.is_number_integer()) {
+            type = schema_type::integer;
+        } else if (val.is_number()) {
+            type = schema_type::number;
+        } else if (val.is_string()) {
+            type = schema_type::string;
+        }
+
+        if (!(types & type)) {
+            return fail(ctx, at, "unexpected type");
+        }
+
+        if (type == schema_type::integer || type == schema_type::number) {
+            const auto n = type == schema_type::integer ? static_cast<number_type>(val.template get<int_type>())
+                                                        : val.template get<number_type>();
+            if ((minimum && n < *minimum) || (maximum && n > *maximum)) {
+                return fail(ctx, at, "number out of range");
+            }
+        } else if (type == schema_type::string) {
+            const auto len = std::get<string_type>(val._value).size();
+            if ((min_length && len < *min_length) || (max_length && len > *max_length)) {
+                return fail(ctx, at, "string length out of range");
+            }
+        }
+
+        return check_enum(val, at, ctx);
+    }
+
+    /// structural comparison, so enums may list objects and arrays as well
+    auto check_enum(const value_type& val, const char* at, context& ctx) const -> bool {
+        if (enumeration.empty() || std::find(enumeration.begin(), enumeration.end(), val) != enumeration.end()) {
+            return true;
+        }
+
+        return fail(ctx, at, "value not in enum");
+    }
+
+    static auto parse_value(const char** p, const basic_schema* s, value_type& val, context& ctx) -> bool {
+        value_type::skip_spaces_and_comments(p);
+        const auto at = *p;
+        const auto ch = **p;
+
+        if (ch == '\0') {
+            return fail(ctx, at, "unexpected end of input");
+        }
+
+        if (!s) {
+            value_type::parse_value(p, val, ctx.options);
+            return *p != at || fail(ctx, at, "invalid value");
+        }
+
+        switch (ch) {
+        case '{':
+            if (!(s->types & schema_type::object)) {
+                return fail(ctx, at, "unexpected object");
+            }
+            return s->parse_object(p, val, ctx) && s->check_enum(val, at, ctx);
+        case '[':
+            if (!(s->types & schema_type::array)) {
+                return fail(ctx, at, "unexpected array");
+            }
+            return s->parse_array(p, val, ctx) && s->check_enum(val, at, ctx);
+        default:
+            value_type::parse_value(p, val, ctx.options);
+            if (*p == at) {
+                return fail(ctx, at, "invalid value");
+            }
+            return s->check_scalar(val, at, ctx);
+        }
+    }
+
+    auto parse_object(const char** p, value_type& val, context& ctx) const -> bool {
+        const auto at = *p;
+        val = object_type {};
+        auto& obj = std::get<object_type>(val._value);
+
+        (*p)++;
+
+        while (true) {
+            value_type::skip_spaces_and_comments(p);
+
+            if (**p == '}') {
+                (*p)++;
+                break;
+            } else if (**p == ',') {
+                (*p)++;
+                continue;
+            } else if (**p == '\0') {
+                return fail(ctx, *p, "unexpected end of input");
+            }
+
+            const auto key_at = *p;
+            const auto key = value_type::parse_key(p);
+            value_type::skip_spaces_and_comments(p);
+            if (std::empty(key) || **p != ':') {
+                return fail(ctx, key_at, "invalid key");
+            }
+            (*p)++;
+
+            const basic_schema* child = nullptr;
+            if (auto it = properties.find(key); it != properties.end()) {
+                child = &it->second;
+            } else if (!additional_properties) {
+                fail(ctx, key_at, "unexpected property");
+                return unwind(ctx, key);
+            }
+
+            value_type duplicate;
+            auto [it, success] = obj.emplace(key, null_type {});
+            if (!parse_value(p, child, success ? it->second : duplicate, ctx)) {
+                return unwind(ctx, key);
+            }
+        }
+
+        for (const auto& key : required) {
+            if (obj.find(key) == obj.end()) {
+                fail(ctx, at, "missing required property");
+                return unwind(ctx, key);
+            }
+        }
+
+        if ((min_properties && obj.size() < *min_properties) || (max_properties && obj.size() > *max_properties)) {
+            return fail(ctx, at, "number of properties out of range");
+        }
+
+        return true;
+    }
+
+    auto parse_array(const char** p, value_type& val, context& ctx) const -> bool {
+        const auto at = *p;
+        const auto integers_only = items && items->types == schema_type::integer && items->enumeration.empty();
+        const auto packed = integers_only && ctx.options.pack_arrays;
+        if (packed) {
+            val = int_array_type {};
+        } else {
+            val = array_type {};
+        }
+
+        (*p)++;
+
+        while (true) {
+            value_type::skip_spaces_and_comments(p);
+
+            if (**p == ']') {
+                (*p)++;
+                break;
+            } else if (**p == ',') {
+                (*p)++;
+                continue;
+            } else if (**p == '\0') {
+                return fail(ctx, *p, "unexpected end of input");
+            }
+
+            const auto idx = val.size();
+            auto ok = false;
+            if (packed) {
+                ok = items->parse_integer(p, std::get<int_array_type>(val._value), ctx);
+            } else if (integers_only) {
+                ok = items->parse_integer(p, std::get<array_type>(val._value), ctx);
+            } else {
+                ok = parse_value(p, items.get(), std::get<array_type>(val._value).emplace_back(null_type {}), ctx);
+            }
+            if (!ok) {
+                return unwind(ctx, std::to_string(idx));
+            }
+        }
+
+        if ((min_items && val.size() < *min_items) || (max_items && val.size() > *max_items)) {
+            return fail(ctx, at, "number of items out of range");
+        }
+
+        return true;
+    }
+
+    /// type directed fast path for arrays of integers, skips the generic value dispatch
+    template <typename Array> auto parse_integer(const char** p, Array& arr, context& ctx) const -> bool {
+        const auto start = *p;
+        auto digits = start;
+        if (*digits == '-' || *digits == '+') {
+            digits++;
+        }
+
+        if (!isdigit(*digits)) {
+            return fail(ctx, start, "unexpected type");
+        }
+
+        const auto base = (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) ? 16 : 10;
+
+        char* end;
+        const auto n = static_cast<int_type>(strtoll(start, &end, base));
+        if (*end == '.' || *end == 'e' || *end == 'E') {
+            return fail(ctx, start, "unexpected type");
+        }
+
+        if ((minimum && static_cast<number_type>(n) < *minimum) || (maximum && static_cast<number_type>(n) > *maximum)) {
+            return fail(ctx, start, "number out of range");
+        }
+
+        arr.emplace_back(n);
+        *p = end;
+        return true;
+    }
+};
+
+using schema = basic_schema<value>;
+
+} // namespace json5
@@ -0,0 +1,162 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace json5 {
+
+///
+/// Holder that publishes immutable documents to concurrent readers
+///
+/// A writer parses a new document anywhere it likes and hands it over with
+/// publish(). Readers take a snapshot, which is a reference to a const tree
+/// that stays valid for as long as they hold it; the previous document is
+/// released when its last snapshot goes away. Readers never wait for parsing
+/// or for the reclamation of old documents. Concurrent writers are serialized
+/// by a mutex that readers never touch.
+///
+template <typename T> class basic_shared_document {
+public:
+    using value_type = T;
+    using snapshot_type = std::shared_ptr<const value_type>;
+    using version_type = std::uint64_t;
+
+    ///
+    /// Per-thread reader
+    ///
+    /// Keeps the last snapshot and reloads it only when a newer version has
+    /// been published, so the common read path is a single atomic load.
+    ///
+    class reader {
+    public:
+        explicit reader(const basic_shared_document& doc)
+            : _doc { &doc } {
+            reload();
+        }
+
+        auto get() -> const value_type& {
+            if (_version != _doc->version()) {
+                reload();
+            }
+            return *_snapshot;
+        }
+
+        auto snapshot() -> const snapshot_type& {
+            get();
+            return _snapshot;
+        }
+
+    private:
+        void reload() {
+            _version = _doc->version();
+            _snapshot = _doc->snapshot();
+        }
+
+        const basic_shared_document* _doc = nullptr;
+        snapshot_type _snapshot;
+        version_type _version = 0;
+    };
+
+    basic_shared_document()
+        : basic_shared_document { value_type {} } {
+    }
+
+    explicit basic_shared_document(value_type val)
+        : _current { std::make_shared<const value_type>(std::move(val)) } {
+    }
+
+    basic_shared_document(const basic_shared_document&) = delete;
+    basic_shared_document& operator=(const basic_shared_document&) = delete;
+
+    auto snapshot() const -> snapshot_type {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        return _current.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&_current, std::memory_order_acquire);
+#endif
+    }
+
+    auto version() const noexcept -> version_type {
+        return _version.load(std::memory_order_acquire);
+    }
+
+    void publish(value_type val) {
+        publish(std::make_shared<const value_type>(std::move(val)));
+    }
+
+    void publish(snapshot_type val) {
+        exchange(std::move(val));
+    }
+
+    /// publishes val unless it equals the current document, for values providing hash() and operator==
+    auto publish_if_changed(value_type val) -> bool {
+        const auto h = val.hash();
+
+        // the comparison and the exchange must not interleave with another writer
+        std::lock_guard<std::mutex> lock { _write };
+        if (_hash != 0 && _hash == h && *snapshot() == val) {
+            return false;
+        }
+
+        exchange_locked(std::make_shared<const value_type>(std::move(val)));
+        _hash = h;
+        return true;
+    }
+
+    /// publishes a new document and returns the previous one
+    auto exchange(snapshot_type val) -> snapshot_type {
+        std::lock_guard<std::mutex> lock { _write };
+        return exchange_locked(std::move(val));
+    }
+
+private:
+    auto exchange_locked(snapshot_type val) -> snapshot_type {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        auto prev = _current.exchange(std::move(val), std::memory_order_acq_rel);
+#else
+        auto prev = std::atomic_exchange_explicit(&_current, std::move(val), std::memory_order_acq_rel);
+#endif
+        _hash = 0;
+        _version.fetch_add(1, std::memory_order_release);
+        return prev;
+    }
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<snapshot_type> _current;
+#else
+    snapshot_type _current;
+#endif
+    std::atomic<version_type> _version { 0 };
+    std::mutex _write;
+    std::uint64_t _hash = 0; // hash of the current document if known, 0 otherwise, guarded by _write
+};
+
+using shared_document = basic_shared_document<value>;
+
+} // namespace json5
@@ -0,0 +1,439 @@
+// MIT License
+
+// Copyright (c) 2021 Michael Poddubny
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <json5/json5.hpp>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace json5 {
+
+///
+/// Blocking file source for basic_stream_parser::for_each
+///
+/// Any type with read(char*, size) returning the number of bytes read, and 0 at
+/// the end of input, can be used as a source.
+///
+class file_source {
+public:
+    explicit file_source(const char* path)
+        : _file { open(path) } {
+    }
+
+    file_source(const file_source&) = delete;
+    file_source& operator=(const file_source&) = delete;
+
+    ~file_source() {
+        if (_file) {
+            std::fclose(_file);
+        }
+    }
+
+    explicit operator bool() const noexcept {
+        return _file != nullptr;
+    }
+
+    auto read(char* buf, std::size_t size) -> std::size_t {
+        return _file ? std::fread(buf, 1, size, _file) : 0;
+    }
+
+    bool failed() const noexcept {
+        return !_file || std::ferror(_file);
+    }
+
+private:
+    static auto open(const char* path) -> std::FILE* {
+#if defined(_MSC_VER)
+        // MSVC deprecates fopen in favour of fopen_s (C4996)
+        std::FILE* file = nullptr;
+        return fopen_s(&file, path, "rb") == 0 ? file : nullptr;
+#else
+        return std::fopen(path, "rb");
+#endif
+    }
+
+    std::FILE* _file = nullptr;
+};
+
+///
+/// Resumable parser for input arriving in chunks
+///
+/// The parser does no I/O itself: feed() accepts whatever a read returned,
+/// from a blocking file, a socket or a completion handler, and next() hands
+/// out every value completed so far. Parsing state is kept between chunks as
+/// a stack of the containers under construction and the bytes of the token in
+/// progress, so feed() resumes exactly where the previous chunk stopped. Only
+/// a single string, number or key is ever buffered, up to max_buffer bytes,
+/// however large the document is. Top level values are emitted as soon as
+/// they are complete and may be separated by any whitespace.
+///
+template <typename JsonValue> class basic_stream_parser {
+public:
+    using value_type = JsonValue;
+    using string_type = typename value_type::string_type;
+    using string_view_type = typename value_type::string_view_type;
+    using object_type = typename value_type::object_type;
+    using array_type = typename value_type::array_type;
+    using size_type = std::size_t;
+
+    static constexpr size_type default_max_buffer = 64 * 1024 * 1024;
+    static constexpr size_type default_chunk_size = 64 * 1024;
+
+    // ctor
+
+    explicit basic_stream_parser(size_type max_buffer = default_max_buffer)
+        : _max_buffer { max_buffer } {
+    }
+
+    /// consumes a chunk of input, returns false on malformed input or once a token outgrows the buffer limit
+    auto feed(string_view_type chunk) -> bool {
+        for (size_type i = 0; i < std::size(chunk) && !_failed;) {
+            if (step(chunk[i])) {
+                i++;
+            }
+        }
+
+        return !_failed;
+    }
+
+    /// marks the end of input, a trailing scalar becomes the final value and an unfinished document fails
+    auto finish() -> void {
+        if (!_failed && _state == state::bare) {
+            finish_bare();
+        }
+
+        const auto open = _state != state::element && _state != state::line_comment;
+        if (!_failed && (!_stack.empty() || open)) {
+            fail();
+        }
+
+        _stack.clear();
+        _token.clear();
+        _state = state::element;
+    }
+
+    /// takes the oldest completed value
+    auto next() -> std::optional<value_type> {
+        if (_values.empty()) {
+            return std::nullopt;
+        }
+
+        auto val = std::move(_values.front());
+        _values.pop_front();
+        return val;
+    }
+
+    /// number of completed values waiting in next()
+    auto ready() const noexcept -> size_type {
+        return std::size(_values);
+    }
+
+    /// bytes held for the token in progress
+    auto buffered() const noexcept -> size_type {
+        return std::size(_token);
+    }
+
+    /// containers opened and not yet closed
+    auto depth() const noexcept -> size_type {
+        return std::size(_stack);
+    }
+
+    bool failed() const noexcept {
+        return _failed;
+    }
+
+    /// pulls the whole source through a fixed size chunk and calls f(value) as soon as values complete
+    template <typename Source, typename Callback>
+    auto for_each(Source& source, Callback&& f, size_type chunk_size = default_chunk_size) -> bool {
+        std::vector<char> chunk(chunk_size);
+
+        while (true) {
+            const auto n = source.read(std::data(chunk), std::size(chunk));
+            if (n == 0) {
+                break;
+            }
+
+            const auto ok = feed({ std::data(chunk), n });
+            while (auto val = next()) {
+                f(std::move(*val));
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+
+        finish();
+        while (auto val = next()) {
+            f(std::move(*val));
+        }
+
+        return !_failed;
+    }
+
+private:
+    enum class state : unsigned char { element, key, colon, string, bare, bare_key, comment, line_comment, block_comment };
+
+    struct frame {
+        value_type container;
+        string_type key;
+    };
+
+    static bool is_delimiter(char c) noexcept {
+        return isspace(static_cast<unsigned char>(c)) || (c != '\0' && strchr(",:[]{}/\"'", c));
+    }
+
+    static bool is_key_char(char c) noexcept {
+        return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    }
+
+    /// consumes c, returns false when c ended a token and has to be looked at again in the next state
+    auto step(char c) -> bool {
+        switch (_state) {
+        case state::element:
+            return step_element(c);
+        case state::key:
+            return step_key(c);
+        case state::colon:
+            if (c == ':') {
+                _state = state::element;
+            } else if (c == '/') {
+                begin_comment();
+            } else if (!isspace(static_cast<unsigned char>(c))) {
+                fail();
+            }
+            return true;
+        case state::string:
+            step_string(c);
+            return true;
+        case state::bare:
+            if (is_delimiter(c)) {
+                finish_bare();
+                return false;
+            }
+            append(c);
+            return true;
+        case state::bare_key:
+            if (!is_key_char(c)) {
+                _stack.back().key = std::move(_token);
+                _token = string_type {};
+                _state = state::colon;
+                return false;
+            }
+            append(c);
+            return true;
+        case state::comment:
+            if (c == '/') {
+                _state = state::line_comment;
+            } else if (c == '*') {
+                _state = state::block_comment;
+                _pending_star = false;
+            } else {
+                fail();
+            }
+            return true;
+        case state::line_comment:
+            if (c == '\n') {
+                _state = _resume;
+            }
+            return true;
+        case state::block_comment:
+            if (_pending_star && c == '/') {
+                _state = _resume;
+            }
+            _pending_star = c == '*';
+            return true;
+        }
+
+        return true;
+    }
+
+    auto step_element(char c) -> bool {
+        switch (c) {
+        case '{':
+            _stack.push_back({ object_type {}, string_type {} });
+            _state = state::key;
+            break;
+        case '[':
+            _stack.push_back({ array_type {}, string_type {} });
+            break;
+        case ']':
+            if (_stack.empty() || _stack.back().container.is_object()) {
+                fail();
+            } else {
+                close();
+            }
+            break;
+        case ',':
+            // commas only separate array elements
+            if (_stack.empty() || _stack.back().container.is_object()) {
+                fail();
+            }
+            break;
+        case '"':
+        case '\'':
+            begin_string(c, false);
+            break;
+        case '/':
+            begin_comment();
+            break;
+        case '}':
+        case ':':
+            fail();
+            break;
+        default:
+            if (!isspace(static_cast<unsigned char>(c))) {
+                _state = state::bare;
+                append(c);
+            }
+        }
+
+        return true;
+    }
+
+    auto step_key(char c) -> bool {
+        if (c == '}') {
+            close();
+        } else if (c == '"' || c == '\'') {
+            begin_string(c, true);
+        } else if (c == '/') {
+            begin_comment();
+        } else if (isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$') {
+            _state = state::bare_key;
+            append(c);
+        } else if (c != ',' && !isspace(static_cast<unsigned char>(c))) {
+            fail();
+        }
+
+        return true;
+    }
+
+    /// same rules as value_type::parse_string: a backslash escapes only the quote, other escapes are kept
+    auto step_string(char c) -> void {
+        append(c);
+        if (_escape) {
+            _escape = false;
+            if (c == _quote) {
+                return;
+            }
+        }
+
+        if (c == '\\') {
+            _escape = true;
+        } else if (c == _quote) {
+            const char* p = _token.c_str();
+            if (_is_key) {
+                _stack.back().key = value_type::parse_key(&p);
+                _state = state::colon;
+            } else {
+                value_type val;
+                value_type::parse_string(&p, val);
+                complete(std::move(val));
+            }
+            _token.clear();
+        }
+    }
+
+    auto begin_string(char quote, bool is_key) -> void {
+        _state = state::string;
+        _quote = quote;
+        _escape = false;
+        _is_key = is_key;
+        append(quote);
+    }
+
+    auto begin_comment() -> void {
+        _resume = _state;
+        _state = state::comment;
+    }
+
+    /// numbers and literals go through value_type::parse_value and have to be consumed completely
+    auto finish_bare() -> void {
+        const auto b = _token.c_str();
+        auto p = b;
+        value_type val;
+        value_type::parse_value(&p, val);
+        if (p == b || *p != '\0') {
+            fail();
+            return;
+        }
+
+        _token.clear();
+        complete(std::move(val));
+    }
+
+    auto append(char c) -> void {
+        _token += c;
+        if (std::size(_token) > _max_buffer) {
+            fail();
+        }
+    }
+
+    auto close() -> void {
+        auto container = std::move(_stack.back().container);
+        _stack.pop_back();
+        complete(std::move(container));
+    }
+
+    auto complete(value_type&& val) -> void {
+        if (_stack.empty()) {
+            _values.push_back(std::move(val));
+            _state = state::element;
+        } else if (auto& top = _stack.back(); top.container.is_object()) {
+            // the first occurrence of a key wins
+            std::get<object_type>(top.container._value).emplace(std::move(top.key), std::move(val));
+            top.key = string_type {};
+            _state = state::key;
+        } else {
+            std::get<array_type>(top.container._value).push_back(std::move(val));
+            _state = state::element;
+        }
+    }
+
+    auto fail() -> void {
+        _failed = true;
+        _stack.clear();
+        _token.clear();
+    }
+
+    std::vector<frame> _stack;
+    string_type _token;
+    std::deque<value_type> _values;
+    size_type _max_buffer = default_max_buffer;
+    state _state = state::element;
+    state _resume = state::element;
+    char _quote = 0;
+    bool _escape = false;
+    bool _is_key = false;
+    bool _pending_star = false;
+    bool _failed = false;
+};
+
+using stream_parser = basic_stream_parser<value>;
+
+} // namespace json5
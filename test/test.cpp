@@ -1,8 +1,21 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
 #include <cmath>
+#include <thread>
+#include <unordered_set>
 
+#include <json5/batch.hpp>
+#include <json5/incremental.hpp>
 #include <json5/json5.hpp>
+#include <json5/literal.hpp>
+#include <json5/overlay.hpp>
+#include <json5/patch.hpp>
+#include <json5/persistent.hpp>
+#include <json5/pmr.hpp>
+#include <json5/projection.hpp>
+#include <json5/schema.hpp>
+#include <json5/shared_document.hpp>
+#include <json5/stream.hpp>
 
 TEST_CASE("JSON5_Parser_spaces") {
     SECTION("Skip spaces") {
@@ -432,4 +445,1245 @@ TEST_CASE("JSON5_ParseArray") {
         REQUIRE(j.is_array());
         REQUIRE(j.size() == 2);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("JSON5_Persistent") {
+    const auto base = json5::persistent_value::parse("{ a: { b: 1, c: [1, 2, 3] }, d: { e: 'x' } }");
+
+    SECTION("Conversion") {
+        REQUIRE(base.is_object());
+        REQUIRE(base.size() == 2);
+        REQUIRE(base["a"]["b"].get<int>() == 1);
+        REQUIRE(base["a"]["c"][2].get<int>() == 3);
+        REQUIRE(base["d"]["e"].get<std::string_view>() == "x");
+
+        auto v = base.to_value();
+        REQUIRE(v["a"]["c"].size() == 3);
+        REQUIRE(v["d"]["e"].get<std::string>() == "x");
+    }
+
+    SECTION("Snapshot shares nodes") {
+        const auto snapshot = base;
+        REQUIRE(snapshot.shares_node_with(base));
+        REQUIRE(snapshot["a"].shares_node_with(base["a"]));
+    }
+
+    SECTION("Path copy on modification") {
+        const auto edited = base.set_in({ "a", "c", 1 }, json5::persistent_value { std::int64_t { 42 } });
+        REQUIRE(edited["a"]["c"][1].get<int>() == 42);
+        REQUIRE(base["a"]["c"][1].get<int>() == 2);
+        REQUIRE_FALSE(edited.shares_node_with(base));
+        REQUIRE_FALSE(edited["a"].shares_node_with(base["a"]));
+        REQUIRE(edited["d"].shares_node_with(base["d"]));
+        REQUIRE(edited["a"]["c"][0].shares_node_with(base["a"]["c"][0]));
+    }
+
+    SECTION("Insert and erase") {
+        const auto inserted = base.set_in({ "f", "g" }, json5::persistent_value { true });
+        REQUIRE(inserted.size() == 3);
+        REQUIRE(inserted["f"]["g"].get<bool>() == true);
+        REQUIRE(base.find("f") == nullptr);
+
+        const auto erased = inserted.erase("a");
+        REQUIRE(erased.size() == 2);
+        REQUIRE(erased.find("a") == nullptr);
+        REQUIRE(erased["d"].shares_node_with(base["d"]));
+
+        const auto appended = base["a"]["c"].push_back(json5::persistent_value { std::int64_t { 4 } });
+        REQUIRE(appended.size() == 4);
+        REQUIRE(base["a"]["c"].size() == 3);
+    }
+
+    SECTION("Wide containers stay ordered and balanced") {
+        auto obj = json5::persistent_value::parse("{}");
+        auto arr = json5::persistent_value::parse("[]");
+        for (std::int64_t i = 0; i < 500; i++) {
+            const auto key = std::to_string((i * 7919) % 500);
+            obj = obj.set(key, json5::persistent_value { i });
+            arr = arr.push_back(json5::persistent_value { i });
+        }
+        REQUIRE(obj.size() == 500);
+        REQUIRE(arr.size() == 500);
+        REQUIRE(obj.find(0) == obj.find("0"));
+        REQUIRE(arr[499].get<int>() == 499);
+
+        const auto edited = arr.set(250, json5::persistent_value { std::int64_t { -1 } });
+        REQUIRE(edited[250].get<int>() == -1);
+        REQUIRE(arr[250].get<int>() == 250);
+        REQUIRE(edited[249].shares_node_with(arr[249]));
+
+        auto erased = obj;
+        for (auto i = 0; i < 500; i += 2) {
+            erased = erased.erase(std::to_string(i));
+        }
+        REQUIRE(erased.size() == 250);
+        REQUIRE(erased.find("2") == nullptr);
+        REQUIRE(erased["3"] == obj["3"]);
+        REQUIRE(obj.size() == 500);
+
+        const auto v = obj.to_value();
+        REQUIRE(v.size() == 500);
+        REQUIRE(json5::persistent_value::from_value(v) == obj);
+        REQUIRE(json5::persistent_value::from_value(v).hash() == v.hash());
+        REQUIRE(json5::persistent_value::from_value(arr.to_value()) == arr);
+    }
+}
+
+TEST_CASE("JSON5_SharedDocument") {
+    SECTION("Find does not copy") {
+        const auto j = json5::value::parse("{ a: [1, 2], b: { c: 'x' } }");
+        REQUIRE(j.find("a") != nullptr);
+        REQUIRE(j.find("a")->find(1)->get<int>() == 2);
+        REQUIRE(j.find("a")->find(2) == nullptr);
+        REQUIRE(j.find(1)->find("c")->get<std::string_view>() == "x");
+        REQUIRE(j.find("z") == nullptr);
+    }
+
+    SECTION("Publish") {
+        json5::shared_document doc { json5::value::parse("{ v: 1 }") };
+        auto old = doc.snapshot();
+        REQUIRE((*old)["v"].get<int>() == 1);
+
+        doc.publish(json5::value::parse("{ v: 2 }"));
+        REQUIRE(doc.version() == 1);
+        REQUIRE((*doc.snapshot())["v"].get<int>() == 2);
+        REQUIRE((*old)["v"].get<int>() == 1);
+    }
+
+    SECTION("Concurrent readers") {
+        json5::shared_document doc { json5::value::parse("{ v: 0 }") };
+        std::atomic<bool> failed { false };
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; i++) {
+            readers.emplace_back([&doc, &failed] {
+                json5::shared_document::reader r { doc };
+                std::int64_t last = 0;
+                while (last < 100) {
+                    const auto v = r.get().find("v")->get<std::int64_t>();
+                    if (v < last) {
+                        failed = true;
+                    }
+                    last = v;
+                }
+            });
+        }
+        for (int v = 1; v <= 100; v++) {
+            doc.publish(json5::value::parse("{ v: " + std::to_string(v) + " }"));
+        }
+        for (auto& t : readers) {
+            t.join();
+        }
+        REQUIRE_FALSE(failed);
+    }
+}
+
+TEST_CASE("JSON5_Batch") {
+    const std::string_view buf = "{ a: 1 }\n"
+                                 "\n"
+                                 "// comment line\n"
+                                 "{ b: 'x\\n}\\'', /* inline */ c: [1, 2] }\n"
+                                 "  42  \n"
+                                 "'last'";
+
+    SECTION("Split records") {
+        std::vector<std::string_view> records;
+        REQUIRE(json5::split_records(buf, records) == 4);
+        REQUIRE(records[0] == "{ a: 1 }");
+        REQUIRE(records[2] == "  42  ");
+        REQUIRE(records[3] == "'last'");
+    }
+
+    SECTION("Callback") {
+        std::vector<std::size_t> order;
+        const auto n = json5::batch_parser::for_each(buf, [&order](std::size_t idx, json5::value v) {
+            order.push_back(idx);
+            if (idx == 1) {
+                REQUIRE(v.is_object());
+                REQUIRE(v["c"].size() == 2);
+            }
+        });
+        REQUIRE(n == 4);
+        REQUIRE(order == std::vector<std::size_t> { 0, 1, 2, 3 });
+    }
+
+    SECTION("Multithreaded keeps order") {
+        std::string many;
+        for (int i = 0; i < 1000; i++) {
+            many += "{ id: " + std::to_string(i) + ", tags: ['a', 'b'] }\n";
+        }
+
+        std::vector<json5::value> out;
+        REQUIRE(json5::batch_parser::parse(many, out, 4) == 1000);
+        REQUIRE(out.size() == 1000);
+        for (int i = 0; i < 1000; i++) {
+            REQUIRE(out[static_cast<std::size_t>(i)]["id"].get<int>() == i);
+        }
+
+        REQUIRE(json5::batch_parser::parse(buf, out) == 4);
+        REQUIRE(out.size() == 4);
+        REQUIRE(out[2].get<int>() == 42);
+        REQUIRE(out[3].get<std::string_view>() == "last");
+    }
+
+    SECTION("Malformed line in the middle") {
+        const std::string_view bad = "{ id: 1 }\n"
+                                     "{ id: 'unterminated }\n"
+                                     "[1, [2, 3]\n"
+                                     "{ id: 4 } ]\n"
+                                     "{ id: 5, /* open comment\n"
+                                     "{ id: 6 }";
+
+        std::vector<std::string_view> records;
+        std::vector<std::size_t> malformed;
+        REQUIRE(json5::split_records(bad, records, &malformed) == 6);
+        REQUIRE(records[3] == "{ id: 4 } ]");
+        REQUIRE(malformed == std::vector<std::size_t> { 1, 2, 3, 4 });
+
+        std::vector<json5::value> out;
+        REQUIRE(json5::batch_parser::parse(bad, out, 2) == 6);
+        REQUIRE(out[0]["id"].get<int>() == 1);
+        REQUIRE(out[1].is_null());
+        REQUIRE(out[2].is_null());
+        REQUIRE(out[4].is_null());
+        REQUIRE(out[5]["id"].get<int>() == 6);
+
+        std::vector<bool> nulls;
+        json5::batch_parser::for_each(bad, [&nulls](std::size_t, json5::value v) { nulls.push_back(v.is_null()); });
+        REQUIRE(nulls == std::vector<bool> { false, true, true, true, true, false });
+    }
+}
+
+TEST_CASE("JSON5_Schema") {
+    const auto s = json5::schema::compile(json5::value::parse(R"({
+        type: 'object',
+        required: ['name', 'ports'],
+        additionalProperties: false,
+        properties: {
+            name: { type: 'string', minLength: 1 },
+            mode: { enum: ['fast', 'safe'] },
+            ratio: { type: 'number', minimum: 0, maximum: 1 },
+            ports: { type: 'array', minItems: 1, items: { type: 'integer', minimum: 1, maximum: 65535 } },
+            tags: { type: ['array', 'null'] },
+        },
+    })"));
+
+    SECTION("Valid document") {
+        json5::schema_error err;
+        auto j = s.parse("{ name: 'srv', mode: 'fast', ratio: 0.5, ports: [80, 443, 0x1F90], tags: null }", &err);
+        REQUIRE(j.has_value());
+        REQUIRE((*j)["name"].get<std::string_view>() == "srv");
+        REQUIRE((*j)["ports"].size() == 3);
+        REQUIRE((*j)["ports"][2].get<int>() == 8080);
+    }
+
+    SECTION("Missing required key") {
+        json5::schema_error err;
+        REQUIRE_FALSE(s.parse("{ name: 'srv' }", &err));
+        REQUIRE(err.path == "/ports");
+        REQUIRE(err.message == "missing required property");
+    }
+
+    SECTION("Wrong item type") {
+        json5::schema_error err;
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [80, 1.5] }", &err));
+        REQUIRE(err.path == "/ports/1");
+        REQUIRE(err.offset == 27);
+    }
+
+    SECTION("Out of range") {
+        json5::schema_error err;
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [70000] }", &err));
+        REQUIRE(err.path == "/ports/0");
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [1], ratio: 2 }", &err));
+        REQUIRE(err.path == "/ratio");
+    }
+
+    SECTION("Enum and additional properties") {
+        json5::schema_error err;
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [1], mode: 'slow' }", &err));
+        REQUIRE(err.message == "value not in enum");
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [1], mode: { x: 1 } }", &err));
+        REQUIRE(err.message == "value not in enum");
+        REQUIRE(err.path == "/mode");
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [1], mode: [] }", &err));
+        REQUIRE(err.message == "value not in enum");
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [1], extra: 1 }", &err));
+        REQUIRE(err.path == "/extra");
+        REQUIRE_FALSE(s.parse("{ name: '', ports: [1] }", &err));
+        REQUIRE_FALSE(s.parse("[1, 2]", &err));
+        REQUIRE(err.message == "unexpected array");
+        REQUIRE_FALSE(s.parse("{ name: 'srv', ports: [1", &err));
+        REQUIRE(err.message == "unexpected end of input");
+    }
+
+    SECTION("Enums of containers") {
+        const auto shapes = json5::schema::compile(json5::value::parse("{ enum: [[1, 2], { a: [true] }, 'none'] }"));
+        json5::schema_error err;
+        REQUIRE(shapes.parse("[1, 2]", &err));
+        REQUIRE(shapes.parse("{ a: [true] }", &err));
+        REQUIRE(shapes.parse("'none'", &err));
+        REQUIRE_FALSE(shapes.parse("[2, 1]", &err));
+        REQUIRE(err.message == "value not in enum");
+        REQUIRE_FALSE(shapes.parse("{ a: [false] }", &err));
+        REQUIRE_FALSE(shapes.parse("{}", &err));
+    }
+
+    SECTION("Size keywords apply to their own type") {
+        const auto mixed = json5::schema::compile(
+            json5::value::parse("{ type: ['string', 'array', 'object'], minLength: 3, maxItems: 2, minProperties: 1 }"));
+        json5::schema_error err;
+        REQUIRE(mixed.parse("[1]", &err));
+        REQUIRE(mixed.parse("'abc'", &err));
+        REQUIRE(mixed.parse("{ a: 1 }", &err));
+        REQUIRE_FALSE(mixed.parse("'ab'", &err));
+        REQUIRE(err.message == "string length out of range");
+        REQUIRE_FALSE(mixed.parse("[1, 2, 3]", &err));
+        REQUIRE(err.message == "number of items out of range");
+        REQUIRE_FALSE(mixed.parse("{}", &err));
+        REQUIRE(err.message == "number of properties out of range");
+    }
+}
+
+#if defined(JSON5_ENABLE_STATS)
+TEST_CASE("JSON5_Stats") {
+    json5::parse_stats reported;
+    json5::stats_callback() = [&reported](const json5::parse_stats& stats) { reported = stats; };
+
+    const std::string_view doc = "{ a: [1, 2.5, NaN], 'b': { c: 'a somewhat longer string value', \"d\": null, e: true } }";
+    json5::value::parse(doc);
+    json5::stats_callback() = nullptr;
+
+    const auto stats = json5::last_parse_stats();
+    REQUIRE(stats.bytes_scanned == doc.size());
+    REQUIRE(stats.objects == 2);
+    REQUIRE(stats.arrays == 1);
+    REQUIRE(stats.integers == 1);
+    REQUIRE(stats.numbers == 2);
+    REQUIRE(stats.strings == 1);
+    REQUIRE(stats.keys == 5);
+    REQUIRE(stats.nulls == 1);
+    REQUIRE(stats.booleans == 1);
+    REQUIRE(stats.max_depth == 2);
+    REQUIRE(stats.estimated_allocations > 0);
+    REQUIRE(stats.estimated_bytes_allocated > 0);
+    REQUIRE(reported.bytes_scanned == stats.bytes_scanned);
+    REQUIRE(reported.objects == stats.objects);
+
+    // keys beyond the small string buffer are counted, quoted or not
+    json5::value::parse("{ a: 1, 'b': 2 }");
+    const auto short_keys = json5::last_parse_stats();
+    json5::value::parse("{ a_key_longer_than_the_small_string_buffer: 1, 'another key longer than the small buffer': 2 }");
+    const auto long_keys = json5::last_parse_stats();
+    REQUIRE(long_keys.estimated_allocations == short_keys.estimated_allocations + 2);
+    REQUIRE(long_keys.estimated_bytes_allocated > short_keys.estimated_bytes_allocated + 80);
+}
+#endif
+
+namespace {
+constexpr std::string_view static_config = R"(
+{
+    // embedded configuration
+    name: 'service',
+    "port": 8080,
+    ratio: 0.25,
+    big: 1.5e3,
+    mask: -0xFF,
+    debug: false,
+    nothing: null,
+    hosts: ['a', "b", /* third */ 'c',],
+    limits: { soft: 10, hard: 20 },
+}
+)";
+
+constexpr auto static_doc = json5::parse_static<json5::static_node_count(static_config)>(static_config);
+
+static_assert(static_doc.root().is_object());
+static_assert(static_doc.root().size() == 9);
+static_assert(static_doc.root()["name"].get<std::string_view>() == "service");
+static_assert(static_doc.root()["port"].get<int>() == 8080);
+static_assert(static_doc.root()["ratio"].get<double>() == 0.25);
+static_assert(static_doc.root()["big"].get<double>() == 1500.0);
+static_assert(static_doc.root()["mask"].get<int>() == -255);
+static_assert(static_doc.root()["debug"].get<bool>() == false);
+static_assert(static_doc.root()["nothing"].is_null());
+static_assert(static_doc.root()["hosts"].size() == 3);
+static_assert(static_doc.root()["hosts"][2].get<std::string_view>() == "c");
+static_assert(static_doc.root()["limits"]["hard"].get<int>() == 20);
+static_assert(static_doc.root()["missing"].is_null());
+
+constexpr auto static_array = JSON5_LITERAL("[1, [2, 3], {a: 4}]");
+static_assert(static_array.root()[1][1].get<int>() == 3);
+static_assert(static_array.root()[2]["a"].get<int>() == 4);
+
+constexpr auto static_numbers
+    = JSON5_LITERAL("[123456789012345678901234.5, 1e99999999999, 1e-99999999999, -9223372036854775808, 0.0000000000000000000000015]");
+static_assert(static_numbers.root()[0].get<double>() > 1.2345678901e23 && static_numbers.root()[0].get<double>() < 1.2345678902e23);
+static_assert(static_numbers.root()[1].get<double>() == std::numeric_limits<double>::infinity());
+static_assert(static_numbers.root()[2].get<double>() == 0.0);
+static_assert(static_numbers.root()[3].get<std::int64_t>() == std::numeric_limits<std::int64_t>::min());
+static_assert(static_numbers.root()[4].get<double>() > 1.4999e-24 && static_numbers.root()[4].get<double>() < 1.5001e-24);
+} // namespace
+
+TEST_CASE("JSON5_Literal") {
+    SECTION("Conversion") {
+        const auto j = static_doc.root().to_value();
+        REQUIRE(j.is_object());
+        REQUIRE(j["name"].get<std::string_view>() == "service");
+        REQUIRE(j["hosts"].size() == 3);
+        REQUIRE(j["limits"]["soft"].get<int>() == 10);
+    }
+
+    SECTION("Syntax errors") {
+        REQUIRE_THROWS(json5::static_node_count("{ a: 1"));
+        REQUIRE_THROWS(json5::static_node_count("[1 2]"));
+        REQUIRE_THROWS(json5::static_node_count("'abc"));
+        REQUIRE_THROWS(json5::static_node_count("/* abc"));
+        REQUIRE_THROWS(json5::static_node_count(""));
+    }
+
+    SECTION("Integers out of range") {
+        REQUIRE_THROWS(json5::static_node_count("9223372036854775808"));
+        REQUIRE_THROWS(json5::static_node_count("123456789012345678901"));
+        REQUIRE_THROWS(json5::static_node_count("0x10000000000000000"));
+        REQUIRE_THROWS(json5::static_node_count("0x8000000000000000"));
+        REQUIRE_THROWS(json5::static_node_count("0xFFFFFFFFFFFFFFFF"));
+        REQUIRE_THROWS(json5::static_node_count("-0x8000000000000001"));
+        REQUIRE(json5::parse_static<1>("0x7FFFFFFFFFFFFFFF").root().get<std::int64_t>() == std::numeric_limits<std::int64_t>::max());
+        REQUIRE(json5::parse_static<1>("-0x8000000000000000").root().get<std::int64_t>() == std::numeric_limits<std::int64_t>::min());
+        REQUIRE(json5::static_node_count("123456789012345678901.0") == 1);
+    }
+}
+
+TEST_CASE("JSON5_Malformed") {
+    SECTION("Unterminated multi line comment") {
+        const char* s = "/* abc";
+        json5::value::skip_spaces_and_comments(&s);
+        REQUIRE(*s == '\0');
+    }
+
+    SECTION("Multi line comment ending with **/") {
+        const char* s = "/* abc **/a";
+        json5::value::skip_spaces_and_comments(&s);
+        REQUIRE(*s == 'a');
+    }
+
+    SECTION("Unterminated string") {
+        const char* s = "'abc";
+        json5::value val;
+        json5::value::parse_string(&s, val);
+        REQUIRE(*s == '\0');
+    }
+
+    SECTION("Unterminated containers") {
+        REQUIRE(json5::value::parse("[1, 2").size() == 2);
+        REQUIRE(json5::value::parse("{ a: 1").size() == 1);
+        REQUIRE(json5::value::parse("[1, @, 2]").size() == 2);
+    }
+
+    SECTION("Keys") {
+        auto j = json5::value::parse("{ \"quoted\": 1, 'single' : 2, spaced  : 3, $dollar$: 4 }");
+        REQUIRE(j.size() == 4);
+        REQUIRE(j["quoted"].get<int>() == 1);
+        REQUIRE(j["single"].get<int>() == 2);
+        REQUIRE(j["spaced"].get<int>() == 3);
+        REQUIRE(j["$dollar$"].get<int>() == 4);
+    }
+
+    SECTION("Duplicate keys") {
+        auto j = json5::value::parse("{ a: 1, a: 'two', b: 3 }");
+        REQUIRE(j.size() == 2);
+        REQUIRE(j["a"].get<int>() == 1);
+        REQUIRE(j["b"].get<int>() == 3);
+    }
+
+    SECTION("Exponents") {
+        auto j = json5::value::parse("[1e3, -2.5E-2, 0x1E]");
+        REQUIRE(j.size() == 3);
+        REQUIRE(j[0].get<double>() == 1000.0);
+        REQUIRE(j[1].get<double>() == -0.025);
+        REQUIRE(j[2].get<int>() == 30);
+    }
+}
+
+TEST_CASE("JSON5_PackedArray") {
+    const json5::parse_options packed { true };
+
+    SECTION("Packing is opt-in") {
+        auto j = json5::value::parse("{ a: [1, 2, 3], b: [true, false] }");
+        REQUIRE_FALSE(j["a"].is_packed_array());
+        REQUIRE_FALSE(j["b"].is_packed_array());
+        REQUIRE(j.find("a")->find(2)->get<int>() == 3);
+        REQUIRE(std::get<json5::value::array_type>(j.find("b")->_value).size() == 2);
+        REQUIRE(j == json5::value::parse("{ a: [1, 2, 3], b: [true, false] }", packed));
+    }
+
+    SECTION("Integers") {
+        auto j = json5::value::parse("[1, -2, 0x10]", packed);
+        REQUIRE(j.is_array());
+        REQUIRE(j.is_packed_array());
+        REQUIRE(j.size() == 3);
+        REQUIRE(j[2].get<int>() == 16);
+        REQUIRE(j.at_opt(3).is_null());
+
+        const auto ints = j.int_span();
+        REQUIRE(ints.size() == 3);
+        REQUIRE(ints[1] == -2);
+        REQUIRE(j.number_span().empty());
+    }
+
+    SECTION("Doubles") {
+        auto j = json5::value::parse("[0.5, -1.25, Infinity]", packed);
+        REQUIRE(j.is_packed_array());
+        const auto numbers = j.number_span();
+        REQUIRE(numbers.size() == 3);
+        REQUIRE(numbers[0] == 0.5);
+        REQUIRE(std::isinf(numbers[2]));
+        REQUIRE(j[1].get<double>() == -1.25);
+    }
+
+    SECTION("Booleans") {
+        auto j = json5::value::parse("[true, false, true]", packed);
+        REQUIRE(j.is_packed_array());
+        REQUIRE(j.boolean_bits() != nullptr);
+        REQUIRE(j.boolean_bits()->size() == 3);
+        REQUIRE(j[0].get<bool>() == true);
+        REQUIRE(j[1].get<bool>() == false);
+    }
+
+    SECTION("Mixed elements fall back to nodes") {
+        auto j = json5::value::parse("[1, 2, 3.5]", packed);
+        REQUIRE(j.is_array());
+        REQUIRE_FALSE(j.is_packed_array());
+        REQUIRE(j.size() == 3);
+        REQUIRE(j[1].get<int>() == 2);
+        REQUIRE(j[2].get<double>() == 3.5);
+        REQUIRE(j.find(0)->get<int>() == 1);
+    }
+
+    SECTION("Unpack") {
+        auto j = json5::value::parse("[[1, 2], [true]]", packed);
+        REQUIRE(j[0].is_packed_array());
+        REQUIRE(j[1].is_packed_array());
+
+        auto inner = j[0];
+        inner.unpack();
+        REQUIRE_FALSE(inner.is_packed_array());
+        REQUIRE(inner.size() == 2);
+        REQUIRE(inner.find(1)->get<int>() == 2);
+    }
+}
+
+TEST_CASE("JSON5_Incremental") {
+    const std::string source = "{\n  name: 'app',\n  window: { width: 640, height: 480 },\n  plugins: [ { id: 'a' }, { id: 'b' } ],\n  tags: [1, 2, 3]\n}";
+
+    SECTION("Edit inside a nested object") {
+        json5::incremental_document doc { source };
+        const auto* plugins = doc.root().find("plugins");
+        REQUIRE(plugins != nullptr);
+
+        const auto offset = doc.source().find("640");
+        REQUIRE(doc.edit(offset, 3, "1280"));
+        REQUIRE(doc.root()["window"]["width"].get<int>() == 1280);
+        REQUIRE(doc.root()["window"]["height"].get<int>() == 480);
+
+        // untouched subtrees stay in place
+        REQUIRE(doc.root().find("plugins") == plugins);
+        REQUIRE(doc.root()["plugins"][1]["id"].get<std::string>() == "b");
+    }
+
+    SECTION("Spans are shifted after an edit") {
+        json5::incremental_document doc { source };
+        REQUIRE(doc.edit(doc.source().find("app"), 3, "application"));
+        REQUIRE(doc.root()["name"].get<std::string>() == "application");
+
+        REQUIRE(doc.edit(doc.source().find("'b'"), 3, "'second'"));
+        REQUIRE(doc.root()["plugins"][1]["id"].get<std::string>() == "second");
+        REQUIRE(doc.root()["plugins"][0]["id"].get<std::string>() == "a");
+
+        REQUIRE(doc.edit(doc.source().find("480"), 3, "720"));
+        REQUIRE(doc.root()["window"]["height"].get<int>() == 720);
+
+        REQUIRE(doc.edit(doc.source().find("3]"), 1, "3, 4"));
+        REQUIRE(doc.root()["tags"].size() == 4);
+        REQUIRE(doc.root()["tags"].find(3)->get<int>() == 4);
+    }
+
+    SECTION("Added members and elements") {
+        json5::incremental_document doc { source };
+        REQUIRE(doc.edit(doc.source().find("height"), 0, "depth: 24, "));
+        REQUIRE(doc.root()["window"]["depth"].get<int>() == 24);
+        REQUIRE(doc.root()["window"].size() == 3);
+
+        REQUIRE(doc.edit(doc.source().find("{ id: 'b' }"), 0, "{ id: 'c', opts: [] }, "));
+        REQUIRE(doc.root()["plugins"].size() == 3);
+        REQUIRE(doc.root()["plugins"][1]["id"].get<std::string>() == "c");
+        REQUIRE(doc.root()["plugins"][2]["id"].get<std::string>() == "b");
+
+        REQUIRE(doc.edit(doc.source().find("opts: []") + 7, 0, "true"));
+        REQUIRE(doc.root()["plugins"][1]["opts"][0].get<bool>());
+    }
+
+    SECTION("Unbalanced edits fall back to a full parse") {
+        json5::incremental_document doc { source };
+        REQUIRE_FALSE(doc.edit(doc.source().find("{ width"), 1, ""));
+        REQUIRE_FALSE(doc.edit(0, 0, "// header\n"));
+
+        REQUIRE_FALSE(doc.edit(doc.source().find("width"), 0, "{ "));
+        REQUIRE(doc.root()["name"].get<std::string>() == "app");
+    }
+
+    SECTION("Result matches a full parse") {
+        json5::incremental_document doc { source };
+        doc.edit(doc.source().find("'a'"), 3, "\"x\" /* renamed */");
+        doc.edit(doc.source().find("640"), 3, "[640, 800]");
+
+        const auto expected = json5::value::parse(doc.source());
+        REQUIRE(doc.root()["plugins"][0]["id"].get<std::string>() == expected["plugins"][0]["id"].get<std::string>());
+        REQUIRE(doc.root()["window"]["width"].is_array());
+        REQUIRE(doc.root()["window"]["width"][1].get<int>() == 800);
+        REQUIRE(doc.root()["tags"][2].get<int>() == 3);
+    }
+
+    SECTION("Wide objects with duplicate keys") {
+        std::string wide = "{ k: { first: true }, ";
+        for (int i = 0; i < 2000; i++) {
+            wide += "k" + std::to_string(i) + ": [" + std::to_string(i) + "], ";
+        }
+        wide += "k: { first: false } }";
+
+        json5::incremental_document doc { wide };
+        REQUIRE(doc.edit(doc.source().find("[1500]") + 1, 4, "-1"));
+        REQUIRE(doc.root()["k1500"][0].get<int>() == -1);
+        REQUIRE(doc.edit(doc.source().find("true"), 4, "1"));
+        REQUIRE(doc.root()["k"]["first"].get<int>() == 1);
+        REQUIRE(doc.root() == json5::value::parse(doc.source()));
+    }
+}
+
+TEST_CASE("JSON5_Stream") {
+    SECTION("Values split across chunks") {
+        json5::stream_parser parser;
+        REQUIRE(parser.feed("{ a: 1, b: [1,"));
+        REQUIRE(parser.ready() == 0);
+        REQUIRE(parser.feed(" 2] }\n{ a: 'x"));
+        REQUIRE(parser.ready() == 1);
+        REQUIRE(parser.feed("\ny' }\n"));
+        REQUIRE(parser.ready() == 2);
+
+        auto first = parser.next();
+        REQUIRE(first);
+        REQUIRE((*first)["b"][1].get<int>() == 2);
+
+        auto second = parser.next();
+        REQUIRE(second);
+        REQUIRE((*second)["a"].get<std::string>() == "x\ny");
+        REQUIRE_FALSE(parser.next());
+    }
+
+    SECTION("Multi line document and comments") {
+        const std::string source = "// config\n{\n  name: 'app', /* split\n comment */\n  list: [\n    1,\n    2\n  ]\n}\n";
+
+        json5::stream_parser parser;
+        for (const auto ch : source) {
+            REQUIRE(parser.feed({ &ch, 1 }));
+        }
+        parser.finish();
+
+        REQUIRE(parser.ready() == 1);
+        auto val = parser.next();
+        REQUIRE((*val)["name"].get<std::string>() == "app");
+        REQUIRE((*val)["list"].size() == 2);
+    }
+
+    SECTION("Last value without newline") {
+        json5::stream_parser parser;
+        parser.feed("1\n2");
+        REQUIRE(parser.ready() == 1);
+        parser.finish();
+        REQUIRE(parser.ready() == 2);
+        parser.next();
+        REQUIRE(parser.next()->get<int>() == 2);
+    }
+
+    SECTION("Buffer limit applies to a single token") {
+        std::string doc = "{ items: [";
+        for (int i = 0; i < 200; i++) {
+            doc += "{ id: " + std::to_string(i) + ", name: 'item' }, ";
+        }
+        doc += "] }";
+        REQUIRE(doc.size() > 2048);
+
+        json5::stream_parser parser { 1024 };
+        for (std::size_t i = 0; i < doc.size(); i += 7) {
+            REQUIRE(parser.feed(std::string_view { doc }.substr(i, 7)));
+            REQUIRE(parser.buffered() <= 1024);
+        }
+        REQUIRE(parser.ready() == 1);
+        REQUIRE(parser.depth() == 0);
+        REQUIRE(*parser.next() == json5::value::parse(doc));
+
+        json5::stream_parser small { 8 };
+        REQUIRE(small.feed("[1, 2]\n"));
+        REQUIRE_FALSE(small.feed("['a long string']"));
+        REQUIRE(small.failed());
+        REQUIRE(small.buffered() == 0);
+        REQUIRE(small.next()->size() == 2);
+    }
+
+    SECTION("Resumes at every byte") {
+        const std::string source = "{ \"quoted key\": 'it\\'s', $k: [1.5e3, -0x10, true, null, Infinity], nested: { a: [[], {}] }, a: 2 } 7 'x'";
+        json5::stream_parser parser;
+        for (const auto ch : source) {
+            REQUIRE(parser.feed({ &ch, 1 }));
+        }
+        parser.finish();
+        REQUIRE_FALSE(parser.failed());
+        REQUIRE(parser.ready() == 3);
+        REQUIRE(*parser.next() == json5::value::parse("{ \"quoted key\": 'it\\'s', $k: [1.5e3, -0x10, true, null, Infinity], nested: { a: [[], {}] }, a: 2 }"));
+        REQUIRE(parser.next()->get<int>() == 7);
+        REQUIRE(parser.next()->get<std::string_view>() == "x");
+    }
+
+    SECTION("Malformed input") {
+        json5::stream_parser unbalanced;
+        REQUIRE_FALSE(unbalanced.feed("[1, 2}"));
+        REQUIRE(unbalanced.failed());
+
+        json5::stream_parser unfinished;
+        REQUIRE(unfinished.feed("{ a: [1, 2"));
+        REQUIRE(unfinished.depth() == 2);
+        unfinished.finish();
+        REQUIRE(unfinished.failed());
+        REQUIRE(unfinished.ready() == 0);
+    }
+
+    SECTION("Source") {
+        struct memory_source {
+            std::string data;
+            std::size_t offset = 0;
+
+            auto read(char* buf, std::size_t size) -> std::size_t {
+                const auto n = std::min(size, data.size() - offset);
+                std::copy_n(data.data() + offset, n, buf);
+                offset += n;
+                return n;
+            }
+        };
+
+        memory_source source { "{ id: 1 }\n{ id: 2 }\n{ id: 3 }" };
+        std::vector<int> ids;
+
+        json5::stream_parser parser;
+        REQUIRE(parser.for_each(source, [&ids](json5::value v) { ids.push_back(v["id"].get<int>()); }, 4));
+        REQUIRE(ids == std::vector<int> { 1, 2, 3 });
+
+        json5::file_source missing { "/nonexistent/file.json5" };
+        REQUIRE_FALSE(missing);
+        REQUIRE(missing.read(nullptr, 0) == 0);
+    }
+}
+
+TEST_CASE("JSON5_Patch") {
+    const auto from = json5::value::parse("{ name: 'app', list: [1, 2, 3], window: { width: 640, 'a/b': 1 }, gone: true }");
+    const auto to = json5::value::parse("{ name: 'app', list: [1, 5, 3, 4], window: { width: 800, 'a/b': 1 }, added: 'x' }");
+
+    SECTION("Diff") {
+        const auto patch = json5::diff(from, to);
+        REQUIRE(patch.is_array());
+
+        std::vector<std::string> ops;
+        for (std::size_t i = 0; i < patch.size(); i++) {
+            ops.push_back(patch[i]["op"].get<std::string>() + " " + patch[i]["path"].get<std::string>());
+        }
+        REQUIRE(ops == std::vector<std::string> { "add /added", "remove /gone", "replace /list/1", "add /list/3", "replace /window/width" });
+        REQUIRE(patch[2]["value"].get<int>() == 5);
+
+        REQUIRE(json5::diff(from, from).size() == 0);
+    }
+
+    SECTION("Apply") {
+        const auto patched = json5::apply_patch(from, json5::diff(from, to));
+        REQUIRE(patched);
+        REQUIRE(json5::diff(*patched, to).size() == 0);
+        REQUIRE((*patched)["list"].size() == 4);
+        REQUIRE((*patched)["list"][3].get<int>() == 4);
+    }
+
+    SECTION("Pointer escaping") {
+        const auto a = json5::value::parse("{ 'a/b': { 'c~d': 1 } }");
+        const auto b = json5::value::parse("{ 'a/b': { 'c~d': 2 } }");
+        const auto patch = json5::diff(a, b);
+        REQUIRE(patch.size() == 1);
+        REQUIRE(patch[0]["path"].get<std::string>() == "/a~1b/c~0d");
+        REQUIRE(json5::apply_patch(a, patch).value()["a/b"]["c~d"].get<int>() == 2);
+    }
+
+    SECTION("Operations") {
+        const auto doc = json5::value::parse("{ a: { b: [1, 2] }, c: 'x' }");
+        const auto patch = json5::value::parse(R"([
+            { op: 'test', path: '/c', value: 'x' },
+            { op: 'add', path: '/a/b/-', value: 3 },
+            { op: 'copy', from: '/a/b', path: '/d' },
+            { op: 'move', from: '/c', path: '/a/e' },
+            { op: 'remove', path: '/a/b/0' }
+        ])");
+
+        const auto patched = json5::apply_patch(doc, patch);
+        REQUIRE(patched);
+        REQUIRE((*patched)["a"]["b"].size() == 2);
+        REQUIRE((*patched)["a"]["b"][0].get<int>() == 2);
+        REQUIRE((*patched)["d"].size() == 3);
+        REQUIRE((*patched)["a"]["e"].get<std::string>() == "x");
+        REQUIRE((*patched).find("c") == nullptr);
+
+        REQUIRE_FALSE(json5::apply_patch(doc, json5::value::parse("[{ op: 'test', path: '/c', value: 'y' }]")));
+        REQUIRE_FALSE(json5::apply_patch(doc, json5::value::parse("[{ op: 'remove', path: '/missing' }]")));
+        REQUIRE_FALSE(json5::apply_patch(doc, json5::value::parse("[{ op: 'add', path: '/a/b/5', value: 1 }]")));
+        REQUIRE_FALSE(json5::apply_patch(json5::value::parse("[1, 2, 3]"),
+            json5::value::parse("[{ op: 'replace', path: '/18446744073709551616', value: 9 }]")));
+        REQUIRE_FALSE(json5::apply_patch(json5::value::parse("[1, 2, 3]"),
+            json5::value::parse("[{ op: 'remove', path: '/99999999999999999999999' }]")));
+        REQUIRE_FALSE(json5::apply_patch(doc, json5::value::parse("[{ op: 'move', from: '/a', path: '/a/x' }]")));
+    }
+
+    SECTION("Merge patch") {
+        const auto patch = json5::merge_diff(from, to);
+        REQUIRE(patch.is_object());
+        REQUIRE(patch["gone"].is_null());
+        REQUIRE(patch["added"].get<std::string>() == "x");
+        REQUIRE(patch["window"].size() == 1);
+        REQUIRE(patch["list"].size() == 4);
+        REQUIRE(patch.find("name") == nullptr);
+
+        auto merged = from;
+        json5::apply_merge_patch(merged, patch);
+        REQUIRE(json5::diff(merged, to).size() == 0);
+
+        REQUIRE(json5::merge_diff(from, from).size() == 0);
+        REQUIRE(json5::merge_diff(json5::value::parse("1"), json5::value::parse("1")).get<int>() == 1);
+    }
+
+    SECTION("Deep documents") {
+        // equal elements in front of and behind the change are ruled out by their hashes
+        std::string nested = "[]";
+        for (int i = 0; i < 200; i++) {
+            nested = "[" + nested + ", " + std::to_string(i) + "]";
+        }
+        const auto a = json5::value::parse("[" + nested + ", 1, " + nested + "]");
+        const auto b = json5::value::parse("[" + nested + ", 2, " + nested + "]");
+
+        const auto patch = json5::diff(a, b);
+        REQUIRE(patch.size() == 1);
+        REQUIRE(patch[std::size_t { 0 }]["path"].get<std::string>() == "/1");
+        REQUIRE(json5::apply_patch(a, patch).value() == b);
+    }
+
+    SECTION("Persistent snapshots") {
+        const auto base = json5::persistent_value::from_value(from);
+        const auto edited = base.set_in({ "window", "width" }, json5::persistent_value { std::int64_t { 800 } })
+                                .set_in({ "list", 1 }, json5::persistent_value { std::int64_t { 5 } })
+                                .erase("gone");
+        const auto patch = json5::diff(base, edited);
+
+        std::vector<std::string> ops;
+        for (std::size_t i = 0; i < patch.size(); i++) {
+            ops.push_back(patch[i]["op"].get<std::string>() + " " + patch[i]["path"].get<std::string>());
+        }
+        REQUIRE(ops == std::vector<std::string> { "remove /gone", "replace /list/1", "replace /window/width" });
+        REQUIRE(json5::apply_patch(from, patch).value() == edited.to_value());
+
+        REQUIRE(json5::diff(base, base).size() == 0);
+        REQUIRE(json5::diff(base, json5::persistent_value::from_value(to)) == json5::diff(from, to));
+    }
+}
+
+TEST_CASE("JSON5_Equality") {
+    SECTION("Values") {
+        const auto a = json5::value::parse("{ a: 1, b: [1, 2], c: { d: 'x', e: null } }");
+        const auto b = json5::value::parse("{ c: { e: null, d: 'x' }, b: [1, 2], a: 1 }");
+        REQUIRE(a == b);
+        REQUIRE(a.hash() == b.hash());
+
+        const auto c = json5::value::parse("{ a: 1, b: [2, 1], c: { d: 'x', e: null } }");
+        REQUIRE(a != c);
+        REQUIRE(a.hash() != c.hash());
+
+        REQUIRE(json5::value::parse("1") != json5::value::parse("1.0"));
+        REQUIRE(json5::value::parse("'1'") != json5::value::parse("1"));
+        REQUIRE(json5::value::parse("{ a: 1 }").hash() != json5::value::parse("{ b: 1 }").hash());
+        REQUIRE(json5::value::parse("{ a: 1, b: 2 }").hash() != json5::value::parse("{ a: 2, b: 1 }").hash());
+    }
+
+    SECTION("Numbers") {
+        REQUIRE(json5::value::parse("NaN") == json5::value::parse("NaN"));
+        REQUIRE(json5::value::parse("NaN").hash() == json5::value::parse("-NaN").hash());
+        REQUIRE(json5::value::parse("-0.0") == json5::value::parse("0.0"));
+        REQUIRE(json5::value::parse("-0.0").hash() == json5::value::parse("0.0").hash());
+    }
+
+    SECTION("Packed arrays equal node arrays") {
+        auto packed = json5::value::parse("[1, 2, 3]", json5::parse_options { true });
+        REQUIRE(packed.is_packed_array());
+        auto nodes = packed;
+        nodes.unpack();
+        REQUIRE_FALSE(nodes.is_packed_array());
+        REQUIRE(packed == nodes);
+        REQUIRE(packed.hash() == nodes.hash());
+
+        REQUIRE(json5::value::parse("[1.5, NaN]") == json5::value::parse("[1.5, NaN]"));
+        REQUIRE(json5::value::parse("[true]") != json5::value::parse("[1]"));
+    }
+
+    SECTION("Stable hash") {
+        REQUIRE(json5::value {}.hash() == json5::detail::hash_mix(json5::detail::hash_null));
+        REQUIRE(json5::value::parse("'hash'").hash() == json5::value { std::string { "hash" } }.hash());
+
+        std::unordered_set<json5::value> cache;
+        cache.insert(json5::value::parse("{ a: [1, 2] }"));
+        cache.insert(json5::value::parse("{ a: [1, 2] } // same"));
+        cache.insert(json5::value::parse("{ a: [1, 3] }"));
+        REQUIRE(cache.size() == 2);
+    }
+
+    SECTION("Persistent values") {
+        const auto a = json5::persistent_value::parse("{ a: { b: [1, 2] }, c: 'x' }");
+        const auto b = a.set_in({ "a", "b", 1 }, json5::persistent_value { json5::value::int_type { 3 } });
+        const auto c = b.set_in({ "a", "b", 1 }, json5::persistent_value { json5::value::int_type { 2 } });
+
+        REQUIRE(a != b);
+        REQUIRE(a == c);
+        REQUIRE(a.hash() == c.hash());
+        REQUIRE(a.hash() == a.to_value().hash());
+        REQUIRE(b.hash() == b.to_value().hash());
+    }
+
+    SECTION("Publish if changed") {
+        json5::shared_document doc;
+        REQUIRE(doc.publish_if_changed(json5::value::parse("{ a: 1 }")));
+        const auto version = doc.version();
+        REQUIRE_FALSE(doc.publish_if_changed(json5::value::parse("{ a: 1 } // reloaded")));
+        REQUIRE(doc.version() == version);
+        REQUIRE(doc.publish_if_changed(json5::value::parse("{ a: 2 }")));
+        REQUIRE(doc.version() == version + 1);
+    }
+
+    SECTION("Concurrent writers") {
+        // exactly one of the writers publishing the same document sees a change
+        json5::shared_document doc;
+        std::atomic<int> published { 0 };
+        std::vector<std::thread> writers;
+        for (int i = 0; i < 4; i++) {
+            writers.emplace_back([&doc, &published] {
+                if (doc.publish_if_changed(json5::value::parse("{ a: [1, 2, 3] }"))) {
+                    published++;
+                }
+            });
+        }
+        for (auto& t : writers) {
+            t.join();
+        }
+        REQUIRE(published == 1);
+        REQUIRE(doc.version() == 1);
+    }
+}
+
+TEST_CASE("JSON5_Projection") {
+    const std::string source = R"({
+        name: 'app',
+        // skipped subtrees may contain anything the parser accepts
+        skipped: { text: "a \"quoted\" ]}", list: [1, [2, { x: '}' }]], /* ] */ n: -Infinity },
+        window: { width: 640, height: 480, title: 'main' },
+        plugins: [ { id: 'a', opts: { big: [1, 2, 3] } }, { id: 'b' }, 7 ],
+        name: 'duplicate',
+    })";
+
+    SECTION("Skip value") {
+        const char* p = source.c_str() + source.find("{ text");
+        json5::value::skip_value(&p);
+        REQUIRE(std::string { p }.find(", /* ] */ n") == std::string::npos);
+        REQUIRE(*p == ',');
+
+        const char* s = "'it\\'s' next";
+        json5::value::skip_value(&s);
+        REQUIRE(std::string { s } == " next");
+
+        const char* n = "  0x1F, 2";
+        json5::value::skip_value(&n);
+        REQUIRE(*n == ',');
+
+        const char* u = "[1, [2";
+        json5::value::skip_value(&u);
+        REQUIRE(*u == '\0');
+    }
+
+    SECTION("Top level keys") {
+        json5::projection selection;
+        selection.add("name").add("window");
+
+        const auto val = selection.parse(source);
+        REQUIRE(val.size() == 2);
+        REQUIRE(val["name"].get<std::string>() == "app");
+        REQUIRE(val["window"] == json5::value::parse(source)["window"]);
+        REQUIRE(val.find("skipped") == nullptr);
+    }
+
+    SECTION("Nested paths") {
+        const json5::projection selection { { "window", "width" }, { "plugins", "id" } };
+
+        const auto val = selection.parse(source);
+        REQUIRE(val["window"].size() == 1);
+        REQUIRE(val["window"]["width"].get<int>() == 640);
+
+        REQUIRE(val["plugins"].size() == 3);
+        REQUIRE(val["plugins"][0].size() == 1);
+        REQUIRE(val["plugins"][0]["id"].get<std::string>() == "a");
+        REQUIRE(val["plugins"][1]["id"].get<std::string>() == "b");
+        REQUIRE(val["plugins"][2].is_null());
+    }
+
+    SECTION("Shorter paths win") {
+        json5::projection selection;
+        selection.add({ "window", "width" }).add("window").add({ "window", "height" });
+        REQUIRE(selection.parse(source)["window"].size() == 3);
+    }
+
+    SECTION("Paths sharing a prefix") {
+        const json5::projection selection { { "window", "title" }, { "plugins", "opts", "big" }, { "name" }, { "window", "height" } };
+
+        const auto val = selection.parse(source);
+        REQUIRE(val.size() == 3);
+        REQUIRE(val["window"] == json5::value::parse("{ height: 480, title: 'main' }"));
+        REQUIRE(val["plugins"][0] == json5::value::parse("{ opts: { big: [1, 2, 3] } }"));
+        REQUIRE(val["plugins"][1].size() == 0);
+    }
+
+    SECTION("Empty selection") {
+        REQUIRE(json5::projection {}.parse(source).size() == 0);
+        REQUIRE(json5::projection {}.parse("").is_null());
+        REQUIRE(json5::projection { { "a" } }.parse("[1, 2]").size() == 2);
+    }
+}
+
+namespace {
+struct counting_resource : std::pmr::memory_resource {
+    std::size_t allocated = 0;
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override {
+        allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        allocated -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+        return this == &other;
+    }
+};
+
+// makes any allocation from the default resource fail the test
+struct default_resource_guard {
+    default_resource_guard()
+        : previous { std::pmr::set_default_resource(std::pmr::null_memory_resource()) } {
+    }
+
+    ~default_resource_guard() {
+        std::pmr::set_default_resource(previous);
+    }
+
+    std::pmr::memory_resource* previous;
+};
+} // namespace
+
+TEST_CASE("JSON5_Pmr") {
+    const std::string source = "{ name: 'a string longer than the small string buffer', 'quoted key longer than sixteen': [1, 2], "
+                               "list: [{ id: 'x' }, true, 1.5], flags: [true, false] }";
+
+    SECTION("Parse") {
+        counting_resource resource;
+        {
+            const default_resource_guard guard;
+            const auto val = json5::pmr::parse(source, &resource);
+            REQUIRE(resource.allocated > 0);
+            REQUIRE(json5::pmr::resource_of(val) == &resource);
+            REQUIRE(val["name"].get<std::string_view>() == "a string longer than the small string buffer");
+            REQUIRE(val["list"][0]["id"].get<std::string_view>() == "x");
+            REQUIRE(val["flags"].find(1)->get<bool>() == false);
+        }
+        REQUIRE(resource.allocated == 0);
+    }
+
+    SECTION("Copies stay in their resource") {
+        counting_resource resource;
+        const default_resource_guard guard;
+        const auto val = json5::pmr::parse(source, &resource);
+        const auto used = resource.allocated;
+
+        auto copy = val;
+        REQUIRE(copy == val);
+        REQUIRE(json5::pmr::resource_of(copy) == &resource);
+        REQUIRE(resource.allocated > used);
+
+        auto list = val["list"];
+        REQUIRE(json5::pmr::resource_of(list) == &resource);
+        auto flags = val["flags"];
+        flags.unpack();
+        REQUIRE(json5::pmr::resource_of(flags) == &resource);
+    }
+
+    SECTION("Copy into another resource") {
+        counting_resource first, second;
+        const default_resource_guard guard;
+        const auto val = json5::pmr::parse(source, &first);
+        const auto used = first.allocated;
+
+        const auto moved = json5::pmr::copy(val, &second);
+        REQUIRE(moved == val);
+        REQUIRE(first.allocated == used);
+        REQUIRE(second.allocated > 0);
+        REQUIRE(json5::pmr::resource_of(moved["list"]) == &second); // plain copies of the children keep their resource
+    }
+
+    SECTION("Parse on another thread") {
+        counting_resource resource;
+        const default_resource_guard guard;
+        json5::pmr::value val;
+        std::thread { [&] { val = json5::pmr::parse(source, &resource, json5::parse_options { true }); } }.join();
+        REQUIRE(json5::pmr::resource_of(val) == &resource);
+        REQUIRE(json5::pmr::resource_of(val["list"][0]["id"]) == &resource);
+        REQUIRE(json5::pmr::resource_of(val["flags"]) == &resource);
+        REQUIRE(val["flags"].is_packed_array());
+    }
+
+    SECTION("Modification") {
+        counting_resource resource;
+        const auto from = json5::pmr::parse(source, &resource);
+        const auto to = json5::pmr::parse("{ name: 'changed to another long string value', list: [] }", &resource);
+        const auto patched = json5::apply_patch(from, json5::diff(from, to));
+        REQUIRE(patched);
+        REQUIRE(*patched == to);
+
+        auto merged = from;
+        json5::apply_merge_patch(merged, json5::merge_diff(from, to));
+        REQUIRE(merged == to);
+
+        REQUIRE(json5::pmr::value { std::string_view { "a string view longer than the small buffer" } }.is_string());
+    }
+
+    SECTION("Allocation failures in batch workers") {
+        std::string lines;
+        for (int i = 0; i < 16; i++) {
+            lines += "{ id: " + std::to_string(i) + " }\n";
+        }
+
+        std::vector<json5::pmr::value> out;
+        const default_resource_guard guard;
+        REQUIRE_THROWS_AS(json5::basic_batch_parser<json5::pmr::value>::parse(lines, out, 4), std::bad_alloc);
+    }
+
+    SECTION("Default resource") {
+        const auto val = json5::pmr::value::parse(source);
+        REQUIRE(json5::pmr::resource_of(val) == std::pmr::get_default_resource());
+        REQUIRE(val == json5::pmr::value::parse(source));
+    }
+}
+
+TEST_CASE("JSON5_Overlay") {
+    auto base = json5::value::parse("{ server: { host: 'localhost', port: 80, tls: { enabled: false } }, log: 'info', paths: ['/a', '/b'] }");
+    auto env = json5::value::parse("{ server: { port: 8080, tls: { enabled: true } }, log: 'debug' }");
+    auto host = json5::value::parse("{ server: { host: 'example.org' }, paths: null, extra: [1, 2] }");
+
+    SECTION("Merged view") {
+        json5::layered_document doc { std::vector { base, env, host } };
+        REQUIRE(doc.layer_count() == 3);
+
+        REQUIRE(doc.find("/server/host")->get<std::string>() == "example.org");
+        REQUIRE(doc.find("/server/port")->get<int>() == 8080);
+        REQUIRE(doc.find("/server/tls/enabled")->get<bool>());
+        REQUIRE(doc.find("/log")->get<std::string>() == "debug");
+        REQUIRE(doc.find("/paths") == nullptr);
+        REQUIRE(doc.find("/extra")->is_array());
+        REQUIRE(doc.find("/missing") == nullptr);
+        REQUIRE(doc.find("") == &doc.merged());
+
+        auto expected = base;
+        json5::apply_merge_patch(expected, env);
+        json5::apply_merge_patch(expected, host);
+        REQUIRE(doc.merged() == expected);
+    }
+
+    SECTION("Array elements and escaping") {
+        json5::layered_document doc { std::vector { json5::value::parse("{ 'a/b': [{ x: 1 }, 'y'] }") } };
+        REQUIRE(doc.find("/a~1b/0/x")->get<int>() == 1);
+        REQUIRE(doc.find("/a~1b/1")->get<std::string>() == "y");
+    }
+
+    SECTION("Changed layers are merged incrementally") {
+        json5::layered_document doc { std::vector { base, env, host } };
+        const auto* server = doc.find("/server");
+
+        REQUIRE(doc.set_layer(1, json5::value::parse("{ server: { port: 8080, tls: { enabled: true } }, log: 'warn' }")) == 1);
+        REQUIRE(doc.find("/log")->get<std::string>() == "warn");
+        REQUIRE(doc.find("/server") == server);
+        REQUIRE(doc.find("/server/port")->get<int>() == 8080);
+
+        REQUIRE(doc.set_layer(1, json5::value::parse("{ server: { port: 8080, tls: { enabled: true } }, log: 'warn' }")) == 0);
+
+        REQUIRE(doc.set_layer(1, json5::value::parse("{ log: 'warn' }")) == 1);
+        REQUIRE(doc.find("/server/port")->get<int>() == 80);
+        REQUIRE(doc.find("/server/tls/enabled")->get<bool>() == false);
+        REQUIRE(doc.find("/server/host")->get<std::string>() == "example.org");
+
+        REQUIRE(doc.set_layer(2, json5::value::parse("{ server: null }")) == 3);
+        REQUIRE(doc.find("/server") == nullptr);
+        REQUIRE(doc.find("/server/port") == nullptr);
+        REQUIRE(doc.find("/paths")->size() == 2);
+        REQUIRE(doc.find("/paths/1")->get<std::string>() == "/b");
+    }
+
+    SECTION("Pushed layers") {
+        json5::layered_document doc { std::vector { base } };
+        doc.push_layer(env);
+        doc.push_layer(host);
+
+        json5::layered_document all { std::vector { base, env, host } };
+        REQUIRE(doc.merged() == all.merged());
+        REQUIRE(doc.find("/server/tls/enabled")->get<bool>());
+    }
+
+    SECTION("Layers pushed onto an empty document") {
+        json5::layered_document doc;
+        REQUIRE(doc.find("") != nullptr);
+        REQUIRE(doc.merged().is_null());
+
+        doc.push_layer(base);
+        doc.push_layer(env);
+        REQUIRE(doc.layer_count() == 2);
+        REQUIRE(doc.find("/server/port")->get<int>() == 8080);
+        REQUIRE(doc.find("/paths/0")->get<std::string>() == "/a");
+    }
+
+    SECTION("Packed arrays") {
+        const json5::parse_options packed { true };
+        json5::layered_document doc { std::vector { json5::value::parse("{ ports: [80, 443], flags: [true] }", packed) } };
+        REQUIRE(doc.layer(0)["ports"].is_packed_array());
+        REQUIRE(doc.find("/ports/1")->get<int>() == 443);
+        REQUIRE(doc.find("/flags/0")->get<bool>());
+
+        doc.push_layer(json5::value::parse("{ ports: [8080] }", packed));
+        REQUIRE(doc.find("/ports/0")->get<int>() == 8080);
+        REQUIRE(doc.find("/ports/1") == nullptr);
+    }
+
+    SECTION("Non object layers replace everything below") {
+        json5::layered_document doc { std::vector { base, json5::value::parse("[1, 2]") } };
+        REQUIRE(doc.merged().is_array());
+        REQUIRE(doc.find("/server") == nullptr);
+
+        doc.set_layer(1, json5::value::parse("{ log: 'off' }"));
+        REQUIRE(doc.find("/log")->get<std::string>() == "off");
+        REQUIRE(doc.find("/server/port")->get<int>() == 80);
+    }
+}